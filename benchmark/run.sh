@@ -0,0 +1,278 @@
+#!/usr/bin/env bash
+#
+# Benchmark suite for the exercises.
+#
+# Sweeps problem sizes and thread and rank counts for GameOfLife (OpenMP and batch mode),
+# GameOfLifeMpi (local mpirun), GameOfLifeHybrid, Pi and the Error1/Error2 vector kernels,
+# prints strong and weak scaling tables and compares every throughput against a baseline file.
+# A configuration that fails is recorded as FAILED and the sweep goes on.
+# Exits with 1 if any throughput dropped by more than the threshold or any configuration failed,
+# and with 2 if there is no baseline to compare against.
+#
+# Usage: run.sh [--build-dir DIR] [--baseline FILE] [--update-baseline]
+#               [--threshold FRACTION] [--quick]
+#
+# Results and the default baseline (benchmark_baseline.csv) live in the build directory;
+# create the baseline once per machine with --update-baseline.
+#
+# Environment: BENCH_SIZES (board edge lengths, default "256 1024"),
+#              BENCH_VECTOR_SIZES (default "1000000 10000000"),
+#              BENCH_THREADS (default "1 2 4"), BENCH_RANKS (default "1 2 4"),
+#              BENCH_REPEAT (default 3), MPIRUN (default "mpirun"),
+#              MPIRUN_FLAGS (default "--oversubscribe").
+
+set -u
+
+BUILD_DIR="$(pwd)"
+BASELINE=""
+UPDATE_BASELINE=0
+THRESHOLD=0.10
+QUICK=0
+
+while [ $# -gt 0 ]; do
+    case "$1" in
+        --build-dir) BUILD_DIR="$2"; shift ;;
+        --baseline) BASELINE="$2"; shift ;;
+        --update-baseline) UPDATE_BASELINE=1 ;;
+        --threshold) THRESHOLD="$2"; shift ;;
+        --quick) QUICK=1 ;;
+        *) echo "ERROR: Unknown option $1" >&2; exit 2 ;;
+    esac
+    shift
+done
+
+BUILD_DIR="$(cd "$BUILD_DIR" && pwd)"
+BASELINE="${BASELINE:-$BUILD_DIR/benchmark_baseline.csv}"
+if [ "$UPDATE_BASELINE" -eq 0 ] && [ ! -f "$BASELINE" ]; then
+    echo "ERROR: No baseline $BASELINE, create it with --update-baseline" >&2
+    exit 2
+fi
+
+THREADS="${BENCH_THREADS:-1 2 4}"
+RANKS="${BENCH_RANKS:-1 2 4}"
+REPEAT="${BENCH_REPEAT:-3}"
+MPIRUN="${MPIRUN:-mpirun}"
+
+# Board edge lengths (per worker for weak scaling, in total for strong scaling) and vector lengths
+if [ "$QUICK" -eq 1 ]; then
+    SIZES="${BENCH_SIZES:-128 256}"; VECTOR_SIZES="${BENCH_VECTOR_SIZES:-1000000}"; REPEAT=1
+else
+    SIZES="${BENCH_SIZES:-256 1024}"; VECTOR_SIZES="${BENCH_VECTOR_SIZES:-1000000 10000000}"
+fi
+
+WORK_DIR="$(mktemp -d)"
+trap 'rm -rf "$WORK_DIR"' EXIT
+RESULTS="$BUILD_DIR/benchmark_results.csv"
+echo "name,workers,seconds,throughput,unit" > "$RESULTS"
+FAILURES=0
+
+# Smallest value of the "Average wall time" / "Time" line over REPEAT runs, in seconds
+best_of() {
+    local pattern="$1"; shift
+    local best=""
+    for _ in $(seq "$REPEAT"); do
+        local value
+        value=$( (cd "$WORK_DIR" && "$@" 2>/dev/null) | awk -v p="$pattern" 'index($0, p) == 1 { v = $(NF - 1) } END { print v }')
+        if [ -z "$value" ]; then
+            echo "ERROR: No \"$pattern\" in output of: $*" >&2
+            return 1
+        fi
+        best=$(awk -v a="$value" -v b="$best" 'BEGIN { print (b == "" || a < b) ? a : b }')
+    done
+    awk -v ms="$best" 'BEGIN { printf "%.6f\n", ms / 1000.0 }'
+}
+
+# Largest value of field $2 on the line starting with $1 over REPEAT runs, 0 if there is none
+best_rate() {
+    local kernel="$1" field="$2"; shift 2
+    local best=0
+    for _ in $(seq "$REPEAT"); do
+        local value
+        value=$( (cd "$WORK_DIR" && "$@" 2>/dev/null) | awk -v k="$kernel" -v f="$field" '$1 == k { print $f }')
+        best=$(awk -v a="${value:-0}" -v b="$best" 'BEGIN { print (a > b) ? a : b }')
+    done
+    echo "$best"
+}
+
+record() {
+    echo "$1,$2,$3,$4,$5" >> "$RESULTS"
+}
+
+failed() {
+    echo "WARNING: $1 failed, continuing" >&2
+    record "$1" "$2" 0 0 FAILED
+    FAILURES=$((FAILURES + 1))
+}
+
+# Times a run with best_of and records amount / seconds / 1e6 in unit, or records a failure
+record_time() {
+    local name="$1" workers="$2" amount="$3" unit="$4" pattern="$5"; shift 5
+    local s
+    if s=$(best_of "$pattern" "$@"); then
+        record "$name" "$workers" "$s" "$(awk -v s="$s" -v n="$amount" 'BEGIN { print n / s / 1e6 }')" "$unit"
+    else
+        failed "$name" "$workers"
+    fi
+}
+
+# Records the rate a run reports itself (best_rate), or a failure if it reported none
+record_rate() {
+    local name="$1" workers="$2" unit="$3" kernel="$4" field="$5"; shift 5
+    local rate
+    rate=$(best_rate "$kernel" "$field" "$@")
+    if awk -v r="$rate" 'BEGIN { exit !(r > 0) }'; then
+        record "$name" "$workers" 0 "$rate" "$unit"
+    else
+        echo "ERROR: No \"$kernel\" rate in output of: $*" >&2
+        failed "$name" "$workers"
+    fi
+}
+
+# Prints a scaling table for all results whose name starts with $1. Speedup and
+# efficiency are throughput based, so the same formula serves strong and weak scaling.
+scaling_table() {
+    awk -F, -v prefix="$1" '
+        index($1, prefix) == 1 && $5 == "FAILED" {
+            printf "  %-34s %7d %12s\n", $1, $2, "FAILED"
+            next
+        }
+        index($1, prefix) == 1 {
+            if (base == "") { base = $4; base_workers = $2 }
+            speedup = base > 0 ? $4 / base : 0
+            printf "  %-34s %7d %12.4f %14.2f %-9s %8.2f %9.1f%%\n", $1, $2, $3, $4, $5,
+                   speedup, 100.0 * speedup * base_workers / $2
+        }' "$RESULTS"
+}
+
+print_header() {
+    echo
+    echo "$1"
+    printf "  %-34s %7s %12s %14s %-9s %8s %10s\n" "benchmark" "workers" "seconds" "throughput" "unit" "speedup" "efficiency"
+}
+
+# Splits n threads into a blocks_x x blocks_y grid for GameOfLife -b
+blocks_for() {
+    local n="$1" bx=1
+    while [ $((bx * bx)) -lt "$n" ]; do bx=$((bx * 2)); done
+    while [ $((n % bx)) -ne 0 ]; do bx=$((bx / 2)); done
+    echo "$bx $((n / bx))"
+}
+
+GOL="$BUILD_DIR/gameoflife/GameOfLife"
+GOL_MPI="$BUILD_DIR/gameoflife-mpi/GameOfLifeMpi"
+GOL_HYBRID="$BUILD_DIR/gameoflife-hybrid/GameOfLifeHybrid"
+HAVE_MPI=0
+if command -v "$MPIRUN" > /dev/null 2>&1 && [ -x "$GOL_MPI" ]; then
+    HAVE_MPI=1
+    MPI_FLAGS="${MPIRUN_FLAGS:---oversubscribe}"
+    [ "$(id -u)" -eq 0 ] && MPI_FLAGS="$MPI_FLAGS --allow-run-as-root"
+else
+    echo "WARNING: $MPIRUN or GameOfLifeMpi not found, skipping MPI benchmarks" >&2
+fi
+
+for size in $SIZES; do
+    # ----- GameOfLife (OpenMP) -----
+    for t in $THREADS; do
+        read -r bx by <<< "$(blocks_for "$t")"
+        # Strong: the board stays size^2, blocks shrink
+        record_time "gol_omp_strong_s${size}_t$t" "$t" $((size * size)) "Mcells/s" "Average wall time" \
+            "$GOL" -np -s $((size / bx)) $((size / by)) -b "$bx" "$by"
+        # Weak: every thread keeps a size^2 block
+        record_time "gol_omp_weak_s${size}_t$t" "$t" $((size * size * t)) "Mcells/s" "Average wall time" \
+            "$GOL" -np -s "$size" "$size" -b "$bx" "$by"
+    done
+
+    # ----- GameOfLife batch mode (fixed number of 64x64 boards) -----
+    for t in $THREADS; do
+        export OMP_NUM_THREADS="$t"
+        record_rate "gol_batch_strong_s${size}_t$t" "$t" "boards/s" "Batch:" 12 "$GOL" -s 64 64 --batch $((size / 4))
+        unset OMP_NUM_THREADS
+    done
+
+    # ----- GameOfLifeMpi and GameOfLifeHybrid -----
+    [ "$HAVE_MPI" -eq 1 ] || continue
+    for r in $RANKS; do
+        record_time "gol_mpi_strong_s${size}_r$r" "$r" $((size * size)) "Mcells/s" "Average wall time" \
+            "$MPIRUN" $MPI_FLAGS -np "$r" "$GOL_MPI" --no-write "$size" "$size"
+        record_time "gol_mpi_weak_s${size}_r$r" "$r" $((size * size * r)) "Mcells/s" "Average wall time" \
+            "$MPIRUN" $MPI_FLAGS -np "$r" "$GOL_MPI" --no-write $((size * r)) "$size"
+        # One-sided halo exchange modes
+        for mode in fence pscw; do
+            record_time "gol_mpi_${mode}_strong_s${size}_r$r" "$r" $((size * size)) "Mcells/s" "Average wall time" \
+                "$MPIRUN" $MPI_FLAGS -np "$r" "$GOL_MPI" --no-write --halo "$mode" "$size" "$size"
+        done
+        # Hybrid with one thread per rank: shared memory halos against message halos
+        for mode in shared msg; do
+            flags=""; [ "$mode" = msg ] && flags="--no-shared"
+            OMP_NUM_THREADS=1 record_time "gol_hybrid_${mode}_strong_s${size}_r$r" "$r" $((size * size)) "Mcells/s" \
+                "Average wall time" "$MPIRUN" $MPI_FLAGS -np "$r" "$GOL_HYBRID" $flags "$size" "$size"
+        done
+    done
+done
+
+# ----- Pi (fixed number of samples) -----
+for t in $THREADS; do
+    record_time "pi_strong_t$t" "$t" 5000000 "Msamples/s" "Time" "$BUILD_DIR/pi/Pi" "$t"
+done
+
+# ----- Error1/Error2 vector kernels -----
+for n in $VECTOR_SIZES; do
+    for t in $THREADS; do
+        export OMP_NUM_THREADS="$t"
+        record_rate "vec_mul_strong_n${n}_t$t" "$t" "GB/s" "c=a*b" 4 "$BUILD_DIR/error1/Error1" "$n" 5
+        record_rate "vec_sum_strong_n${n}_t$t" "$t" "GB/s" "sum" 4 "$BUILD_DIR/error2/Error2" "$n" 5
+        unset OMP_NUM_THREADS
+    done
+done
+
+# ----- Scaling tables -----
+print_header "Strong scaling (fixed total problem size)"
+for size in $SIZES; do
+    for prefix in gol_omp_strong gol_batch_strong gol_mpi_strong gol_mpi_fence_strong gol_mpi_pscw_strong gol_hybrid_shared_strong gol_hybrid_msg_strong; do
+        scaling_table "${prefix}_s${size}_"
+    done
+done
+scaling_table "pi_strong_"
+for n in $VECTOR_SIZES; do
+    scaling_table "vec_mul_strong_n${n}_"
+    scaling_table "vec_sum_strong_n${n}_"
+done
+print_header "Weak scaling (fixed problem size per worker)"
+for size in $SIZES; do
+    for prefix in gol_omp_weak gol_mpi_weak; do
+        scaling_table "${prefix}_s${size}_"
+    done
+done
+echo
+echo "Results written to $RESULTS"
+
+# ----- Baseline comparison -----
+if [ "$UPDATE_BASELINE" -eq 1 ]; then
+    echo "name,throughput,unit" > "$BASELINE"
+    awk -F, 'NR > 1 && $5 != "FAILED" { print $1 "," $4 "," $5 }' "$RESULTS" >> "$BASELINE"
+    echo "Baseline written to $BASELINE"
+    [ "$FAILURES" -eq 0 ] || { echo "$FAILURES configuration(s) failed"; exit 1; }
+    exit 0
+fi
+
+echo
+echo "Comparison against $BASELINE (threshold $THRESHOLD)"
+awk -F, -v threshold="$THRESHOLD" -v failures="$FAILURES" '
+    FNR == 1 { next }
+    NR == FNR { baseline[$1] = $2; next }
+    $5 == "FAILED" {
+        printf "  %-34s %14s %14s %9s  FAILED\n", $1, ($1 in baseline) ? baseline[$1] : "-", "-", ""
+        next
+    }
+    ($1 in baseline) && baseline[$1] > 0 {
+        change = $4 / baseline[$1] - 1.0
+        status = change < -threshold ? "REGRESSION" : "ok"
+        if (status != "ok") regressed++
+        printf "  %-34s %14.2f %14.2f %+8.1f%%  %s\n", $1, baseline[$1], $4, 100.0 * change, status
+    }
+    END {
+        if (regressed) printf "%d benchmark(s) regressed\n", regressed
+        if (failures) printf "%d configuration(s) failed\n", failures
+        if (regressed || failures) exit 1
+        print "No regressions"
+    }' "$BASELINE" "$RESULTS"
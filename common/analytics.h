@@ -0,0 +1,148 @@
+#ifndef HPC_ANALYTICS_H
+#define HPC_ANALYTICS_H
+
+/*
+ * In-situ analytics for the Game of Life drivers.
+ *
+ * The evolve kernels fill a step_stats_t per thread while they compute a
+ * generation (population, births, deaths, bounding box, a histogram of the
+ * neighbour counts of living cells and an order independent hash of the
+ * new generation). The driver merges the per thread and per rank stats and
+ * hands them to analytics_record(), which detects periods from the hash
+ * history, appends one line per step to a CSV time series and decides
+ * whether a full frame is worth writing.
+ */
+
+#include <stdbool.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Longest period that is detected
+#define ANALYTICS_HISTORY 64
+
+#define ANALYTICS_BINS 9
+
+typedef struct {
+    long population;
+    long births;
+    long deaths;
+    long histogram[ANALYTICS_BINS]; // living cells by number of living neighbours
+    uint64_t hash;
+    int min_x, min_y, max_x, max_y; // bounding box of the new generation, empty if min_x > max_x
+    int origin_y;                   // global row of the kernel's row 0, set by the caller
+} step_stats_t;
+
+static inline void stats_reset(step_stats_t *stats, int origin_y) {
+    *stats = (step_stats_t) {0};
+    stats->min_x = stats->min_y = INT_MAX;
+    stats->max_x = stats->max_y = INT_MIN;
+    stats->origin_y = origin_y;
+}
+
+// splitmix64 finalizer, summed over living cells so threads and ranks can add their partial hashes
+static inline uint64_t stats_mix(uint64_t index) {
+    index += 0x9e3779b97f4a7c15ull;
+    index = (index ^ (index >> 30)) * 0xbf58476d1ce4e5b9ull;
+    index = (index ^ (index >> 27)) * 0x94d049bb133111ebull;
+    return index ^ (index >> 31);
+}
+
+// Called by the kernels for every cell; x and y are kernel coordinates
+static inline void stats_add_cell(step_stats_t *stats, int x, int y, int width, char old_cell, char new_cell,
+                                  int neighbours) {
+    if (old_cell) {
+        stats->histogram[neighbours]++;
+        stats->deaths += !new_cell;
+    }
+    if (new_cell) {
+        int global_y = y + stats->origin_y;
+        stats->population++;
+        stats->births += !old_cell;
+        stats->hash += stats_mix((uint64_t) global_y * width + x);
+        if (x < stats->min_x) stats->min_x = x;
+        if (x > stats->max_x) stats->max_x = x;
+        if (global_y < stats->min_y) stats->min_y = global_y;
+        if (global_y > stats->max_y) stats->max_y = global_y;
+    }
+}
+
+static inline void stats_merge(step_stats_t *into, const step_stats_t *from) {
+    into->population += from->population;
+    into->births += from->births;
+    into->deaths += from->deaths;
+    for (int b = 0; b < ANALYTICS_BINS; ++b) {
+        into->histogram[b] += from->histogram[b];
+    }
+    into->hash += from->hash;
+    if (from->min_x < into->min_x) into->min_x = from->min_x;
+    if (from->min_y < into->min_y) into->min_y = from->min_y;
+    if (from->max_x > into->max_x) into->max_x = from->max_x;
+    if (from->max_y > into->max_y) into->max_y = from->max_y;
+}
+
+typedef struct {
+    FILE *fp;                               // NULL on ranks that do not write
+    uint64_t history[ANALYTICS_HISTORY];    // hashes of the last generations, by step
+    int period;                             // period detected at the last step, 0 if none
+    int frame_every;                        // write a frame every n steps, 0 disables
+    double frame_trigger;                   // write a frame once (births + deaths) / population exceeds this, 0 disables
+} analytics_t;
+
+static inline bool analytics_open(analytics_t *analytics, const char *filename, int frame_every, double frame_trigger) {
+    *analytics = (analytics_t) {0};
+    analytics->frame_every = frame_every;
+    analytics->frame_trigger = frame_trigger;
+    if (filename == NULL) return true;
+
+    analytics->fp = fopen(filename, "w");
+    if (analytics->fp == NULL) {
+        fprintf(stderr, "WARNING: Could not open analytics file %s\n", filename);
+        return false;
+    }
+    fprintf(analytics->fp, "step,population,births,deaths,min_x,min_y,max_x,max_y,period,hash");
+    for (int b = 0; b < ANALYTICS_BINS; ++b) {
+        fprintf(analytics->fp, ",neighbours_%d", b);
+    }
+    fprintf(analytics->fp, "\n");
+    return true;
+}
+
+// Records the merged stats of the generation produced by step; returns true if a full frame should be written
+static inline bool analytics_record(analytics_t *analytics, int step, const step_stats_t *stats) {
+    int period = 0;
+    for (int k = 1; k <= step && k <= ANALYTICS_HISTORY; ++k) {
+        if (analytics->history[(step - k) % ANALYTICS_HISTORY] == stats->hash) {
+            period = k;
+            break;
+        }
+    }
+    analytics->history[step % ANALYTICS_HISTORY] = stats->hash;
+
+    bool frame = (analytics->frame_every > 0 && step % analytics->frame_every == 0) ||
+                 (period > 0 && period != analytics->period);
+    if (analytics->frame_trigger > 0.0) {
+        long population = stats->population > 0 ? stats->population : 1;
+        frame = frame || (double) (stats->births + stats->deaths) / population > analytics->frame_trigger;
+    }
+    analytics->period = period;
+
+    if (analytics->fp != NULL) {
+        bool empty = stats->min_x > stats->max_x;
+        fprintf(analytics->fp, "%d,%ld,%ld,%ld,%d,%d,%d,%d,%d,%016llx", step, stats->population, stats->births,
+                stats->deaths, empty ? -1 : stats->min_x, empty ? -1 : stats->min_y, empty ? -1 : stats->max_x,
+                empty ? -1 : stats->max_y, period, (unsigned long long) stats->hash);
+        for (int b = 0; b < ANALYTICS_BINS; ++b) {
+            fprintf(analytics->fp, ",%ld", stats->histogram[b]);
+        }
+        fprintf(analytics->fp, "\n");
+    }
+    return frame;
+}
+
+static inline void analytics_close(analytics_t *analytics) {
+    if (analytics->fp != NULL) fclose(analytics->fp);
+    analytics->fp = NULL;
+}
+
+#endif // HPC_ANALYTICS_H
@@ -0,0 +1,138 @@
+#ifndef HPC_LTL_H
+#define HPC_LTL_H
+
+/*
+ * Larger than Life: two state rules on a (2r+1)x(2r+1) Moore neighbourhood,
+ * written in Golly's notation, e.g. Bosco's rule "R5,C2,M1,S34..58,B34..45,NM".
+ *
+ * ltl_evolve() counts neighbourhoods with separable running sums: a column
+ * sum over 2r+1 rows that slides down one row at a time, and a box sum over
+ * 2r+1 of those column sums that slides along the row. Every cell costs O(1)
+ * regardless of the radius; each OpenMP thread only pays O(r) per column
+ * once to prime the column sums of its band of rows.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+typedef struct {
+    int radius;
+    bool center;                    // the cell counts itself (M1)
+    int birth_min, birth_max;
+    int survive_min, survive_max;
+} ltl_rule_t;
+
+static inline int ltl_parse(const char *rulestring, ltl_rule_t *rule) {
+    ltl_rule_t parsed = {0};
+    int states = 2;
+    bool seen_radius = false, seen_birth = false, seen_survive = false;
+
+    const char *token = rulestring;
+    while (*token != '\0') {
+        int length = (int) strcspn(token, ",");
+        int a, b, consumed = 0;
+        char neighbourhood;
+        if (sscanf(token, "R%d%n", &a, &consumed) == 1 && consumed == length) {
+            parsed.radius = a;
+            seen_radius = true;
+        } else if (sscanf(token, "C%d%n", &a, &consumed) == 1 && consumed == length) {
+            states = a;
+        } else if (sscanf(token, "M%d%n", &a, &consumed) == 1 && consumed == length) {
+            parsed.center = a != 0;
+        } else if (sscanf(token, "S%d..%d%n", &a, &b, &consumed) == 2 && consumed == length) {
+            parsed.survive_min = a;
+            parsed.survive_max = b;
+            seen_survive = true;
+        } else if (sscanf(token, "B%d..%d%n", &a, &b, &consumed) == 2 && consumed == length) {
+            parsed.birth_min = a;
+            parsed.birth_max = b;
+            seen_birth = true;
+        } else if (sscanf(token, "N%c%n", &neighbourhood, &consumed) == 1 && consumed == length) {
+            // Only the box (Moore) neighbourhood is separable
+            if (neighbourhood != 'M') return -1;
+        } else {
+            return -1;
+        }
+        token += length;
+        if (*token == ',') token++;
+    }
+    if (!seen_radius || !seen_birth || !seen_survive || parsed.radius < 1 || (states != 0 && states != 2)) {
+        return -1;
+    }
+    *rule = parsed;
+    return 0;
+}
+
+/*
+ * One generation of rows rows, periodic in x. field points to the first of
+ * radius ghost rows above the block and holds rows + 2 * radius rows; the
+ * caller fills the ghost rows (wrap around or halo exchange). new_field
+ * points to the first row of the block. Needs width >= 2 * radius + 1.
+ * Returns the number of cells that changed.
+ */
+static inline long ltl_evolve(const ltl_rule_t *rule, const char *field, char *new_field, int width, int rows) {
+    const int r = rule->radius;
+    long changes = 0;
+
+#pragma omp parallel reduction(+:changes)
+    {
+        int thread = 0, threads = 1;
+#ifdef _OPENMP
+        thread = omp_get_thread_num();
+        threads = omp_get_num_threads();
+#endif
+        int first = (int) ((long) rows * thread / threads);
+        int last = (int) ((long) rows * (thread + 1) / threads);
+        int *column = malloc(width * sizeof(int));
+
+        if (first < last) {
+            // Column sums for the window of the first row: field rows first .. first + 2r
+            memset(column, 0, width * sizeof(int));
+            for (int dy = 0; dy <= 2 * r; ++dy) {
+                const char *row = field + (size_t) (first + dy) * width;
+                for (int x = 0; x < width; ++x) {
+                    column[x] += row[x];
+                }
+            }
+        }
+
+        for (int y = first; y < last; ++y) {
+            if (y > first) {
+                // Slide the window down: add the new bottom row, drop the old top row
+                const char *enter = field + (size_t) (y + 2 * r) * width;
+                const char *leave = field + (size_t) (y - 1) * width;
+                for (int x = 0; x < width; ++x) {
+                    column[x] += enter[x] - leave[x];
+                }
+            }
+
+            const char *center = field + (size_t) (y + r) * width;
+            char *out = new_field + (size_t) y * width;
+            int box = 0;
+            for (int dx = -r; dx <= r; ++dx) {
+                box += column[(dx + width) % width];
+            }
+            for (int x = 0; x < width; ++x) {
+                int count = box - (rule->center ? 0 : center[x]);
+                char alive = center[x] ? (count >= rule->survive_min && count <= rule->survive_max)
+                                       : (count >= rule->birth_min && count <= rule->birth_max);
+                out[x] = alive;
+                changes += alive != center[x];
+
+                // Slide the box right along the torus
+                int enter = x + r + 1, leave = x - r;
+                box += column[enter >= width ? enter - width : enter] - column[leave < 0 ? leave + width : leave];
+            }
+        }
+        free(column);
+    }
+    return changes;
+}
+
+#endif // HPC_LTL_H
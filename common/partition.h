@@ -0,0 +1,19 @@
+#ifndef HPC_PARTITION_H
+#define HPC_PARTITION_H
+
+/*
+ * Even row partition of a board over MPI ranks: height rows are split over
+ * size ranks, and the first height % size ranks take one extra row.
+ */
+
+// Rows of partition rank
+static inline int rows_for(int rank, int size, int height) {
+    return height / size + (rank < height % size ? 1 : 0);
+}
+
+// First board row of partition rank
+static inline int first_row_for(int rank, int size, int height) {
+    return rank * (height / size) + (rank < height % size ? rank : height % size);
+}
+
+#endif // HPC_PARTITION_H
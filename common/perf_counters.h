@@ -0,0 +1,159 @@
+#ifndef HPC_PERF_COUNTERS_H
+#define HPC_PERF_COUNTERS_H
+
+/*
+ * Optional hardware performance counters via perf_event_open(2).
+ *
+ * Each thread or rank opens its own counter group with perf_counters_open()
+ * and brackets the kernel with perf_counters_start()/perf_counters_stop().
+ * Events the kernel or the hardware does not offer (no PMU in a VM,
+ * perf_event_paranoid too strict, non-Linux build) are marked unavailable
+ * and reported as n/a; the program keeps running either way.
+ *
+ * There is no portable memory bandwidth event, so DRAM traffic is estimated
+ * as one cache line per last level cache miss.
+ *
+ * syscall() needs _GNU_SOURCE defined before the first system header under
+ * -std=c99.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+#define PERF_CACHE_LINE 64
+
+typedef enum {
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_LLC_REFERENCES,
+    PERF_LLC_MISSES,
+    PERF_EVENT_COUNT
+} perf_event_t;
+
+static const char *perf_event_names[PERF_EVENT_COUNT] = {"cycles", "instructions", "llc_references", "llc_misses"};
+
+typedef struct {
+    int fd[PERF_EVENT_COUNT];
+    int available[PERF_EVENT_COUNT];
+    uint64_t value[PERF_EVENT_COUNT];
+} perf_counters_t;
+
+#ifdef __linux__
+static const uint64_t perf_event_configs[PERF_EVENT_COUNT] = {
+        PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_REFERENCES,
+        PERF_COUNT_HW_CACHE_MISSES};
+
+static inline int perf_event_open_fd(uint64_t config, int group_fd) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.disabled = group_fd == -1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    // Counts the calling thread on whatever CPU it runs on
+    return (int) syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0);
+}
+#endif
+
+// Opens the counter group for the calling thread; returns the number of available events
+static inline int perf_counters_open(perf_counters_t *pc) {
+    int count = 0;
+    memset(pc, 0, sizeof(*pc));
+    for (int e = 0; e < PERF_EVENT_COUNT; ++e) {
+        pc->fd[e] = -1;
+    }
+    for (int e = 0; e < PERF_EVENT_COUNT; ++e) {
+#ifdef __linux__
+        pc->fd[e] = perf_event_open_fd(perf_event_configs[e], pc->fd[PERF_CYCLES]);
+        if (pc->fd[PERF_CYCLES] < 0) break; // without a group leader nothing else can be counted
+#endif
+        pc->available[e] = pc->fd[e] >= 0;
+        count += pc->available[e];
+    }
+    return count;
+}
+
+static inline void perf_counters_start(perf_counters_t *pc) {
+#ifdef __linux__
+    if (pc->fd[PERF_CYCLES] < 0) return;
+    ioctl(pc->fd[PERF_CYCLES], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(pc->fd[PERF_CYCLES], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+}
+
+// Stops the group and adds the counts since perf_counters_start() to pc->value
+static inline void perf_counters_stop(perf_counters_t *pc) {
+#ifdef __linux__
+    if (pc->fd[PERF_CYCLES] < 0) return;
+    ioctl(pc->fd[PERF_CYCLES], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+    for (int e = 0; e < PERF_EVENT_COUNT; ++e) {
+        uint64_t data[3]; // value, time enabled, time running
+        if (pc->fd[e] < 0 || read(pc->fd[e], data, sizeof(data)) != sizeof(data)) continue;
+        // Scale up if the group was multiplexed with other users of the PMU
+        if (data[2] > 0 && data[2] < data[1]) {
+            data[0] = (uint64_t) ((double) data[0] * data[1] / data[2]);
+        }
+        pc->value[e] += data[0];
+    }
+#endif
+}
+
+static inline void perf_counters_close(perf_counters_t *pc) {
+#ifdef __linux__
+    for (int e = PERF_EVENT_COUNT - 1; e >= 0; --e) {
+        if (pc->fd[e] >= 0) close(pc->fd[e]);
+        pc->fd[e] = -1;
+    }
+#endif
+}
+
+// Sums counts into total; an event stays available only if every contributor had it
+static inline void perf_counters_accumulate(perf_counters_t *total, const perf_counters_t *pc) {
+    for (int e = 0; e < PERF_EVENT_COUNT; ++e) {
+        total->value[e] += pc->value[e];
+        total->available[e] = total->available[e] && pc->available[e];
+    }
+}
+
+// Prints raw counts and the per cell ratios needed to place the kernel on a roofline
+static inline void perf_counters_print(FILE *out, const perf_counters_t *pc, double cells) {
+    const int *ok = pc->available;
+    const uint64_t *v = pc->value;
+
+    if (!ok[PERF_CYCLES]) {
+        fprintf(out, "perf: hardware counters unavailable (check /proc/sys/kernel/perf_event_paranoid)\n");
+        return;
+    }
+    for (int e = 0; e < PERF_EVENT_COUNT; ++e) {
+        if (ok[e]) {
+            fprintf(out, "perf: %-16s %20llu\n", perf_event_names[e], (unsigned long long) v[e]);
+        } else {
+            fprintf(out, "perf: %-16s %20s\n", perf_event_names[e], "n/a");
+        }
+    }
+    if (v[PERF_CYCLES] == 0 || cells <= 0) return;
+
+    fprintf(out, "perf: cells/cycle        %20.4f\n", cells / v[PERF_CYCLES]);
+    if (ok[PERF_INSTRUCTIONS]) {
+        fprintf(out, "perf: instructions/cycle %20.4f\n", (double) v[PERF_INSTRUCTIONS] / v[PERF_CYCLES]);
+        fprintf(out, "perf: instructions/cell  %20.4f\n", v[PERF_INSTRUCTIONS] / cells);
+    }
+    if (ok[PERF_LLC_MISSES]) {
+        fprintf(out, "perf: llc misses/cell    %20.6f\n", v[PERF_LLC_MISSES] / cells);
+        fprintf(out, "perf: dram bytes/cell    %20.4f (estimated from llc misses)\n",
+                v[PERF_LLC_MISSES] * (double) PERF_CACHE_LINE / cells);
+    }
+}
+
+#endif // HPC_PERF_COUNTERS_H
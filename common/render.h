@@ -0,0 +1,285 @@
+#ifndef HPC_RENDER_H
+#define HPC_RENDER_H
+
+/*
+ * Live terminal view for the Game of Life drivers.
+ *
+ * The renderer runs on its own thread at a capped frame rate. Once per frame
+ * it asks for a snapshot, which the simulation hands over with
+ * render_submit(): a single trylock per step, and a copy of the board only
+ * when a frame is due, so the simulation never waits for the terminal.
+ *
+ * Boards larger than the terminal are downsampled onto Unicode braille
+ * (2x4 dots per character) or half-block (1x2) glyphs; a dot is set if any
+ * cell it covers is alive. Only characters that changed since the last frame
+ * are redrawn, and every frame goes out in one buffered write.
+ *
+ * clock_nanosleep() needs _GNU_SOURCE (or _POSIX_C_SOURCE) defined before
+ * the first system header under -std=c99.
+ */
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef __unix__
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+
+#define RENDER_DEFAULT_FPS 20
+
+typedef enum {
+    GLYPHS_BRAILLE,
+    GLYPHS_HALF
+} glyphs_t;
+
+typedef struct {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t ready;
+    bool wanted;            // the renderer waits for a snapshot
+    bool fresh;             // a snapshot arrived that has not been drawn yet
+    bool stop;
+    int width, height;      // board
+    char *snapshot;
+    int step;
+    int fps;
+    glyphs_t glyphs;
+
+    // Owned by the drawing side
+    int cols, rows;         // terminal characters used for the board
+    int dot_w, dot_h;       // dots per character
+    int map_w, map_h;       // dots the board is mapped onto, at most the board size
+    unsigned char *dots;
+    unsigned char *glyph;   // glyph bits per character, last drawn in shown
+    unsigned char *shown;
+    int *dot_x;             // board column -> dot column
+    char *out;
+    size_t out_size;
+    bool cleared;
+} renderer_t;
+
+static inline void render_terminal_size(int *cols, int *rows) {
+    *cols = 80;
+    *rows = 24;
+#if defined(__unix__) && defined(TIOCGWINSZ)
+    struct winsize ws;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0 && ws.ws_col > 0 && ws.ws_row > 1) {
+        *cols = ws.ws_col;
+        *rows = ws.ws_row;
+    }
+#endif
+}
+
+// Sizes the glyph grid for the current terminal, keeping one line for the status; returns true if it changed
+static inline bool render_layout(renderer_t *r) {
+    int term_cols, term_rows;
+    render_terminal_size(&term_cols, &term_rows);
+    term_rows--;
+
+    int cols = (r->width + r->dot_w - 1) / r->dot_w;
+    int rows = (r->height + r->dot_h - 1) / r->dot_h;
+    if (cols > term_cols) cols = term_cols;
+    if (rows > term_rows) rows = term_rows;
+    if (cols == r->cols && rows == r->rows && r->glyph != NULL) return false;
+
+    r->cols = cols;
+    r->rows = rows;
+    int dots_x = cols * r->dot_w, dots_y = rows * r->dot_h;
+    // Never upscale: a board that fits maps one cell to one dot, only larger boards are scaled onto the grid
+    r->map_w = r->width < dots_x ? r->width : dots_x;
+    r->map_h = r->height < dots_y ? r->height : dots_y;
+    free(r->dots);
+    free(r->glyph);
+    free(r->shown);
+    free(r->dot_x);
+    free(r->out);
+    r->dots = malloc((size_t) dots_x * dots_y);
+    r->glyph = malloc((size_t) cols * rows);
+    r->shown = calloc((size_t) cols * rows, 1);
+    r->dot_x = malloc(r->width * sizeof(int));
+    for (int x = 0; x < r->width; ++x) {
+        r->dot_x[x] = (int) ((long) x * r->map_w / r->width);
+    }
+    // Worst case: a cursor move and a 3 byte glyph for every character, plus the status line
+    r->out_size = (size_t) cols * rows * 16 + 256;
+    r->out = malloc(r->out_size);
+    r->cleared = false;
+    return true;
+}
+
+static inline size_t render_glyph(char *out, glyphs_t glyphs, unsigned char bits) {
+    if (glyphs == GLYPHS_HALF) {
+        // ' ', upper half, lower half, full block
+        static const unsigned char half[4] = {0, 0x80, 0x84, 0x88};
+        if (bits == 0) {
+            out[0] = ' ';
+            return 1;
+        }
+        out[0] = (char) 0xE2;
+        out[1] = (char) 0x96;
+        out[2] = (char) half[bits];
+        return 3;
+    }
+    // U+2800 + bits
+    out[0] = (char) 0xE2;
+    out[1] = (char) (0xA0 | (bits >> 6));
+    out[2] = (char) (0x80 | (bits & 0x3F));
+    return 3;
+}
+
+// Draws field with a single write; only called from one thread at a time
+static inline void render_draw(renderer_t *r, const char *field, int step) {
+    if (render_layout(r)) {
+        memset(r->shown, 0, (size_t) r->cols * r->rows);
+    }
+    int dots_x = r->cols * r->dot_w, dots_y = r->rows * r->dot_h;
+
+    // One pass over the board, OR-ing every cell into its dot
+    memset(r->dots, 0, (size_t) dots_x * dots_y);
+    for (int y = 0; y < r->height; ++y) {
+        unsigned char *dot_row = r->dots + (size_t) ((long) y * r->map_h / r->height) * dots_x;
+        const char *row = field + (size_t) y * r->width;
+        for (int x = 0; x < r->width; ++x) {
+            dot_row[r->dot_x[x]] |= row[x] != 0;
+        }
+    }
+
+    // Braille dot numbering: columns 0/1, rows 0-2 first, the bottom row last
+    static const unsigned char braille[4][2] = {{0x01, 0x08}, {0x02, 0x10}, {0x04, 0x20}, {0x40, 0x80}};
+    for (int row = 0; row < r->rows; ++row) {
+        for (int col = 0; col < r->cols; ++col) {
+            unsigned char bits = 0;
+            for (int dy = 0; dy < r->dot_h; ++dy) {
+                const unsigned char *dot = r->dots + (size_t) (row * r->dot_h + dy) * dots_x + col * r->dot_w;
+                for (int dx = 0; dx < r->dot_w; ++dx) {
+                    if (dot[dx]) bits |= r->glyphs == GLYPHS_HALF ? 1 << dy : braille[dy][dx];
+                }
+            }
+            r->glyph[row * r->cols + col] = bits;
+        }
+    }
+
+    // Diff against what is on screen, moving the cursor only across unchanged characters
+    size_t n = 0;
+    if (!r->cleared) {
+        n += (size_t) sprintf(r->out + n, "\033[?25l\033[2J");
+        r->cleared = true;
+    }
+    for (int row = 0; row < r->rows; ++row) {
+        int cursor = -1;
+        for (int col = 0; col < r->cols; ++col) {
+            int i = row * r->cols + col;
+            if (r->glyph[i] == r->shown[i]) continue;
+            if (cursor != col) {
+                n += (size_t) sprintf(r->out + n, "\033[%d;%dH", row + 1, col + 1);
+            }
+            n += render_glyph(r->out + n, r->glyphs, r->glyph[i]);
+            r->shown[i] = r->glyph[i];
+            cursor = col + 1;
+        }
+    }
+    n += (size_t) snprintf(r->out + n, r->out_size - n, "\033[%d;1H\033[Kstep %d  %dx%d  %dx%d cells per dot",
+                           r->rows + 1, step, r->width, r->height,
+                           (r->width + r->map_w - 1) / r->map_w, (r->height + r->map_h - 1) / r->map_h);
+    fwrite(r->out, 1, n, stdout);
+    fflush(stdout);
+}
+
+static inline void *render_thread(void *arg) {
+    renderer_t *r = arg;
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+    long frame_ns = 1000000000L / r->fps;
+
+    for (;;) {
+        pthread_mutex_lock(&r->lock);
+        r->wanted = true;
+        while (!r->fresh && !r->stop) {
+            pthread_cond_wait(&r->ready, &r->lock);
+        }
+        bool draw = r->fresh;
+        r->fresh = false;
+        bool stop = r->stop;
+        pthread_mutex_unlock(&r->lock);
+
+        // The simulation only writes the snapshot while wanted is set, so it is ours until the next frame
+        if (draw) render_draw(r, r->snapshot, r->step);
+        if (stop) break;
+
+        next.tv_nsec += frame_ns;
+        if (next.tv_nsec >= 1000000000L) {
+            next.tv_sec++;
+            next.tv_nsec -= 1000000000L;
+        }
+        // Drop frames instead of catching up after a slow one
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if (now.tv_sec > next.tv_sec || (now.tv_sec == next.tv_sec && now.tv_nsec > next.tv_nsec)) {
+            next = now;
+        }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+    }
+    return NULL;
+}
+
+static inline bool render_open(renderer_t *r, int width, int height, int fps, glyphs_t glyphs) {
+    memset(r, 0, sizeof(*r));
+    r->width = width;
+    r->height = height;
+    r->fps = fps > 0 ? fps : RENDER_DEFAULT_FPS;
+    r->glyphs = glyphs;
+    r->dot_w = glyphs == GLYPHS_HALF ? 1 : 2;
+    r->dot_h = glyphs == GLYPHS_HALF ? 2 : 4;
+    r->snapshot = malloc((size_t) width * height);
+    pthread_mutex_init(&r->lock, NULL);
+    pthread_cond_init(&r->ready, NULL);
+    if (pthread_create(&r->thread, NULL, render_thread, r) != 0) {
+        fprintf(stderr, "WARNING: Could not start render thread\n");
+        free(r->snapshot);
+        r->snapshot = NULL;
+        return false;
+    }
+    return true;
+}
+
+// Called by the simulation every step; copies field only if the renderer is waiting for a frame
+static inline void render_submit(renderer_t *r, const char *field, int step) {
+    if (pthread_mutex_trylock(&r->lock) != 0) return;
+    if (r->wanted) {
+        memcpy(r->snapshot, field, (size_t) r->width * r->height);
+        r->step = step;
+        r->wanted = false;
+        r->fresh = true;
+        pthread_cond_signal(&r->ready);
+    }
+    pthread_mutex_unlock(&r->lock);
+}
+
+// Stops the render thread, draws the final state of field and restores the cursor
+static inline void render_close(renderer_t *r, const char *field, int step) {
+    pthread_mutex_lock(&r->lock);
+    r->stop = true;
+    pthread_cond_signal(&r->ready);
+    pthread_mutex_unlock(&r->lock);
+    pthread_join(r->thread, NULL);
+
+    render_draw(r, field, step);
+    printf("\033[?25h\n");
+    fflush(stdout);
+
+    pthread_mutex_destroy(&r->lock);
+    pthread_cond_destroy(&r->ready);
+    free(r->snapshot);
+    free(r->dots);
+    free(r->glyph);
+    free(r->shown);
+    free(r->dot_x);
+    free(r->out);
+}
+
+#endif // HPC_RENDER_H
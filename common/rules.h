@@ -0,0 +1,112 @@
+#ifndef HPC_RULES_H
+#define HPC_RULES_H
+
+/*
+ * Life-like cellular automaton rules in B/S notation, e.g. "B3/S23".
+ *
+ * A rule is two 9 bit masks indexed by the number of living neighbours:
+ * a dead cell is born if its bit in birth is set, a living cell survives if
+ * its bit in survive is set. Kernels for the rules in RULE_LIST are
+ * instantiated with the masks as compile time constants, everything else
+ * runs through a generic kernel that reads the masks at runtime.
+ */
+
+#include <ctype.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#define RULE_BIT(n) (1u << (n))
+
+// Next state of a cell with n living neighbours
+#define RULE_NEXT(birth, survive, alive, n) ((char) ((((alive) ? (survive) : (birth)) >> (n)) & 1u))
+
+// X(data, name, rulestring, birth mask, survive mask) for the rules with specialized kernels
+#define RULE_LIST(X, data) \
+    X(data, conway,    "B3/S23",       RULE_BIT(3), \
+                                       RULE_BIT(2) | RULE_BIT(3)) \
+    X(data, highlife,  "B36/S23",      RULE_BIT(3) | RULE_BIT(6), \
+                                       RULE_BIT(2) | RULE_BIT(3)) \
+    X(data, day_night, "B3678/S34678", RULE_BIT(3) | RULE_BIT(6) | RULE_BIT(7) | RULE_BIT(8), \
+                                       RULE_BIT(3) | RULE_BIT(4) | RULE_BIT(6) | RULE_BIT(7) | RULE_BIT(8)) \
+    X(data, seeds,     "B2/S",         RULE_BIT(2), \
+                                       0u)
+
+/*
+ * Defines the kernels of a driver around body(birth, survive, args...), an
+ * always inline kernel body returning bool; the masks fold into constants
+ * when it is inlined into a specialized kernel. Every kernel takes params,
+ * the parenthesized parameter list of fn_type, which must name its rule_t
+ * rule; args are the parenthesized arguments body takes after the masks.
+ *
+ * Defines kernel, the generic kernel that reads the masks at runtime,
+ * kernel_<name> for every rule in RULE_LIST, and select(rule), which returns
+ * the specialized kernel for rule or else kernel.
+ */
+#define RULE_DEFINE_KERNELS(fn_type, select, kernel, body, params, args) \
+    RULE_LIST(RULE_KERNEL_, (kernel, body, params, args)) \
+    bool kernel params { \
+        return body(rule.birth, rule.survive, RULE_UNPAREN_ args); \
+    } \
+    fn_type select(rule_t rule) { \
+        RULE_LIST(RULE_SELECT_, kernel) \
+        return kernel; \
+    }
+
+#define RULE_UNPAREN_(...) __VA_ARGS__
+#define RULE_CALL_(macro, args) macro args
+#define RULE_KERNEL_(data, name, rulestring, birth_mask, survive_mask) \
+    RULE_CALL_(RULE_SPECIALIZED_, (RULE_UNPAREN_ data, name, birth_mask, survive_mask))
+#define RULE_SPECIALIZED_(kernel, body, params, args, name, birth_mask, survive_mask) \
+    static bool kernel##_##name params { \
+        return body(birth_mask, survive_mask, RULE_UNPAREN_ args); \
+    }
+#define RULE_SELECT_(kernel, name, rulestring, birth_mask, survive_mask) \
+    if (rule.birth == (birth_mask) && rule.survive == (survive_mask)) return kernel##_##name;
+
+typedef struct {
+    unsigned birth;
+    unsigned survive;
+} rule_t;
+
+static const rule_t RULE_CONWAY = {RULE_BIT(3), RULE_BIT(2) | RULE_BIT(3)};
+
+// Parses "B.../S..." (either order, case insensitive); returns 0 on success, -1 on error
+static inline int rule_parse(const char *rulestring, rule_t *rule) {
+    unsigned *mask = NULL;
+    bool seen_birth = false, seen_survive = false;
+    rule_t parsed = {0u, 0u};
+
+    for (const char *c = rulestring; *c != '\0'; ++c) {
+        char upper = (char) toupper((unsigned char) *c);
+        if (upper == 'B' && !seen_birth) {
+            mask = &parsed.birth;
+            seen_birth = true;
+        } else if (upper == 'S' && !seen_survive) {
+            mask = &parsed.survive;
+            seen_survive = true;
+        } else if (*c >= '0' && *c <= '8' && mask != NULL) {
+            *mask |= RULE_BIT(*c - '0');
+        } else if (*c != '/' || mask == NULL) {
+            return -1;
+        }
+    }
+    if (!seen_birth || !seen_survive) {
+        return -1;
+    }
+    *rule = parsed;
+    return 0;
+}
+
+static inline void rule_format(rule_t rule, char *buffer, size_t size) {
+    size_t pos = 0;
+    pos += snprintf(buffer + pos, size - pos, "B");
+    for (int n = 0; n <= 8 && pos < size; ++n) {
+        if (rule.birth & RULE_BIT(n)) pos += snprintf(buffer + pos, size - pos, "%d", n);
+    }
+    if (pos < size) pos += snprintf(buffer + pos, size - pos, "/S");
+    for (int n = 0; n <= 8 && pos < size; ++n) {
+        if (rule.survive & RULE_BIT(n)) pos += snprintf(buffer + pos, size - pos, "%d", n);
+    }
+}
+
+#endif // HPC_RULES_H
@@ -0,0 +1,139 @@
+#ifndef HPC_TIMING_H
+#define HPC_TIMING_H
+
+/*
+ * Wall-clock phase timing shared by the Game of Life drivers.
+ *
+ * Every worker (OpenMP thread or MPI rank) owns one phase_timer_t and
+ * brackets the parts of a time step with timer_start()/timer_stop(). The
+ * accumulated totals are then reduced to min/avg/max per phase and written
+ * as a human readable table and as JSON or CSV.
+ *
+ * The clock defaults to clock_gettime(CLOCK_MONOTONIC); a driver can define
+ * TIMING_NOW() before including this header to use omp_get_wtime() or
+ * MPI_Wtime() instead.
+ *
+ * posix_memalign() and clock_gettime() need _GNU_SOURCE (or _POSIX_C_SOURCE)
+ * defined before the first system header under -std=c99.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef TIMING_NOW
+#define TIMING_NOW() timing_clock()
+#endif
+
+#define TIMING_CACHE_LINE 64
+
+typedef enum {
+    PHASE_EVOLVE,
+    PHASE_HALO,
+    PHASE_CONVERGENCE,
+    PHASE_IO,
+    PHASE_ANALYTICS,
+    PHASE_BALANCE,
+    PHASE_COUNT
+} phase_t;
+
+static const char *phase_names[PHASE_COUNT] = {"evolve", "halo", "convergence", "io", "analytics", "balance"};
+
+// Padded to a cache line so per-thread timers in one array do not false share
+typedef struct {
+    double start;
+    double total[PHASE_COUNT];
+    char pad[TIMING_CACHE_LINE - (PHASE_COUNT + 1) * sizeof(double)];
+} phase_timer_t;
+
+static inline double timing_clock(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Zeroed, cache line aligned array of count timers; release with free()
+static inline phase_timer_t *timing_alloc(int count) {
+    void *timers = NULL;
+    if (posix_memalign(&timers, TIMING_CACHE_LINE, count * sizeof(phase_timer_t)) != 0) {
+        return NULL;
+    }
+    memset(timers, 0, count * sizeof(phase_timer_t));
+    return timers;
+}
+
+static inline void timer_start(phase_timer_t *timer) {
+    timer->start = TIMING_NOW();
+}
+
+static inline void timer_stop(phase_timer_t *timer, phase_t phase) {
+    timer->total[phase] += TIMING_NOW() - timer->start;
+}
+
+typedef struct {
+    double min, avg, max;
+} phase_stats_t;
+
+// totals holds PHASE_COUNT values per worker, worker after worker
+static inline phase_stats_t timing_stats(const double *totals, int workers, phase_t phase) {
+    phase_stats_t stats = {totals[phase], 0.0, totals[phase]};
+    for (int w = 0; w < workers; ++w) {
+        double value = totals[w * PHASE_COUNT + phase];
+        if (value < stats.min) stats.min = value;
+        if (value > stats.max) stats.max = value;
+        stats.avg += value;
+    }
+    stats.avg /= workers;
+    return stats;
+}
+
+// Load imbalance as max/avg - 1: 0 is perfectly balanced
+static inline double timing_imbalance(phase_stats_t stats) {
+    return stats.avg > 0.0 ? stats.max / stats.avg - 1.0 : 0.0;
+}
+
+static inline void timing_print(FILE *out, const char *unit, const double *totals, int workers, int steps) {
+    fprintf(out, "%-12s %12s %12s %12s %10s   (per step, over %d %ss)\n", "phase", "min [ms]", "avg [ms]",
+            "max [ms]", "imbalance", workers, unit);
+    for (int p = 0; p < PHASE_COUNT; ++p) {
+        phase_stats_t stats = timing_stats(totals, workers, (phase_t) p);
+        if (stats.max == 0.0) continue;
+        fprintf(out, "%-12s %12.3f %12.3f %12.3f %9.1f%%\n", phase_names[p], stats.min * 1000.0 / steps,
+                stats.avg * 1000.0 / steps, stats.max * 1000.0 / steps, timing_imbalance(stats) * 100.0);
+    }
+}
+
+// Writes the summary as JSON if filename ends in ".json", as CSV otherwise
+static inline void timing_write(const char *filename, const char *unit, const double *totals, int workers, int steps) {
+    FILE *fp = fopen(filename, "w");
+    if (fp == NULL) {
+        fprintf(stderr, "WARNING: Could not open timing file %s\n", filename);
+        return;
+    }
+
+    size_t len = strlen(filename);
+    if (len >= 5 && strcmp(filename + len - 5, ".json") == 0) {
+        fprintf(fp, "{\"unit\": \"%s\", \"workers\": %d, \"steps\": %d, \"phases\": {", unit, workers, steps);
+        for (int p = 0; p < PHASE_COUNT; ++p) {
+            phase_stats_t stats = timing_stats(totals, workers, (phase_t) p);
+            fprintf(fp, "%s\n  \"%s\": {\"min\": %.9f, \"avg\": %.9f, \"max\": %.9f, \"imbalance\": %.6f, \"per_%s\": [",
+                    p ? "," : "", phase_names[p], stats.min, stats.avg, stats.max, timing_imbalance(stats), unit);
+            for (int w = 0; w < workers; ++w) {
+                fprintf(fp, "%s%.9f", w ? ", " : "", totals[w * PHASE_COUNT + p]);
+            }
+            fprintf(fp, "]}");
+        }
+        fprintf(fp, "\n}}\n");
+    } else {
+        fprintf(fp, "phase,unit,workers,steps,min_s,avg_s,max_s,imbalance\n");
+        for (int p = 0; p < PHASE_COUNT; ++p) {
+            phase_stats_t stats = timing_stats(totals, workers, (phase_t) p);
+            fprintf(fp, "%s,%s,%d,%d,%.9f,%.9f,%.9f,%.6f\n", phase_names[p], unit, workers, steps, stats.min,
+                    stats.avg, stats.max, timing_imbalance(stats));
+        }
+    }
+    fclose(fp);
+}
+
+#endif // HPC_TIMING_H
@@ -1,90 +1,127 @@
 /******************************************************************************
 * FILE: omp_bug3.c
 * DESCRIPTION:
-*   Run time error
+*   Data-parallel vector kernels c = a*b and d = a+b. Every kernel is split
+*   across the whole team with "omp for simd" and timed against a
+*   STREAM-style triad, so the reported GB/s show how close the kernels get
+*   to the memory bandwidth of the machine.
+*   Usage: Error1 [N] [repetitions]
 * AUTHOR: Blaise Barney  01/09/04
 * LAST REVISED: 06/28/05
 ******************************************************************************/
+#define _POSIX_C_SOURCE 200112L
+
 #include <omp.h>
 #include <stdio.h>
 #include <stdlib.h>
-#define N     50
+#define N           10000000
+#define NTIMES      10
+#define ALIGNMENT   64
+#define SCALAR      3.0f
+
+float *alloc_vector(long n);
+void print_results(const char *name, double seconds, long bytes, double baseline);
 
-int main (int argc, char *argv[]) 
+int main (int argc, char *argv[])
 {
-int i, nthreads, tid, section;
-float a[N], b[N], c[N];
-void print_results(float array[N], int tid, int section);
+long i, n = N;
+int k, ntimes = NTIMES, nthreads;
+float *a, *b, *c, *d;
+double t, best[3], baseline;
 
-/* Some initializations */
-for (i=0; i<N; i++)
-  a[i] = b[i] = i * 1.0;
+if (argc > 1)
+  n = atol(argv[1]);
+if (argc > 2)
+  ntimes = atoi(argv[2]);
+if (n <= 0)
+  n = N;
+if (ntimes <= 0)
+  ntimes = NTIMES;
+for (k=0; k<3; k++)
+  best[k] = 1.0e30;
 
-#pragma omp parallel private(i,c,tid,section)
+a = alloc_vector(n);
+b = alloc_vector(n);
+c = alloc_vector(n);
+d = alloc_vector(n);
+
+/* First touch with the same static schedule as the kernels */
+#pragma omp parallel
   {
-  tid = omp_get_thread_num();
-  if (tid == 0)
-    {
+  #pragma omp master
     nthreads = omp_get_num_threads();
-    printf("Number of threads = %d\n", nthreads);
+
+  #pragma omp for simd schedule(static)
+  for (i=0; i<n; i++) {
+    a[i] = b[i] = i * 1.0f;
+    c[i] = d[i] = 0.0f;
     }
+  }
+
+printf("Number of threads = %d\n", nthreads);
+printf("Vector length = %ld (%.1f MiB per vector), best of %d runs\n",
+       n, n * sizeof(float) / (1024.0 * 1024.0), ntimes);
+
+for (k=0; k<ntimes; k++) {
+  /* STREAM triad as bandwidth baseline */
+  t = omp_get_wtime();
+  #pragma omp parallel for simd schedule(static)
+  for (i=0; i<n; i++)
+    d[i] = a[i] + SCALAR * b[i];
+  t = omp_get_wtime() - t;
+  if (t < best[0]) best[0] = t;
+
+  t = omp_get_wtime();
+  #pragma omp parallel for simd schedule(static)
+  for (i=0; i<n; i++)
+    c[i] = a[i] * b[i];
+  t = omp_get_wtime() - t;
+  if (t < best[1]) best[1] = t;
 
-  /*** Use barriers for clean output ***/
-  #pragma omp barrier
-  printf("Thread %d starting...\n",tid);
-  #pragma omp barrier
-
-  #pragma omp sections nowait
-    {
-    #pragma omp section
-      {
-      section = 1;
-      for (i=0; i<N; i++)
-        c[i] = a[i] * b[i];
-      print_results(c, tid, section);
-      }
-
-    #pragma omp section
-      {
-      section = 2;
-      for (i=0; i<N; i++)
-        c[i] = a[i] + b[i];
-      print_results(c, tid, section);
-      }
-
-    }  /* end of sections */
-
-  /*** Use barrier for clean output ***/
-  #pragma omp barrier
-  printf("Thread %d exiting...\n",tid);
-
-  }  /* end of parallel section */
+  t = omp_get_wtime();
+  #pragma omp parallel for simd schedule(static)
+  for (i=0; i<n; i++)
+    d[i] = a[i] + b[i];
+  t = omp_get_wtime() - t;
+  if (t < best[2]) best[2] = t;
+  }
+
+/* Verify the last results, c and d each hold their own kernel output */
+long errors = 0;
+#pragma omp parallel for simd reduction(+:errors)
+for (i=0; i<n; i++)
+  errors += (c[i] != (float) i * (float) i) + (d[i] != (float) i + (float) i);
+
+baseline = 3.0 * n * sizeof(float) / best[0];
+print_results("triad", best[0], 3 * n * sizeof(float), baseline);
+print_results("c=a*b", best[1], 3 * n * sizeof(float), baseline);
+print_results("d=a+b", best[2], 3 * n * sizeof(float), baseline);
+printf("Verification: %s (%ld errors)\n", errors ? "FAILED" : "passed", errors);
+
+free(a);
+free(b);
+free(c);
+free(d);
+return errors ? 1 : 0;
 }
 
 
 
-void print_results(float array[N], int tid, int section) 
+float *alloc_vector(long n)
 {
-  int i,j;
+  void *p;
 
-  j = 1;
-  /*** use critical for clean output ***/
-  #pragma omp critical
-  {
-  printf("\nThread %d did section %d. The results are:\n", tid, section);
-  for (i=0; i<N; i++) {
-    printf("%e  ",array[i]);
-    j++;
-    if (j == 6) {
-      printf("\n");
-      j = 1;
-      }
+  if (posix_memalign(&p, ALIGNMENT, n * sizeof(float)) != 0) {
+    fprintf(stderr, "ERROR: Could not allocate %ld floats\n", n);
+    exit(1);
     }
-    printf("\n");
-  } /*** end of critical ***/
+  return p;
+}
 
-  //#pragma omp barrier
-  printf("Thread %d done.\n", tid); 
+void print_results(const char *name, double seconds, long bytes, double baseline)
+{
+  double rate = bytes / seconds;
 
+  printf("%-8s %10.3f ms %10.2f GB/s %7.1f%% of triad\n",
+         name, seconds * 1000.0, rate * 1.0e-9, 100.0 * rate / baseline);
 }
-  
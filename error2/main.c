@@ -1,79 +1,140 @@
 /******************************************************************************
 * FILE: omp_bug5.c
 * DESCRIPTION:
-*   Using SECTIONS, two threads initialize their own array and then add
-*   it to the other's array, however a deadlock occurs.
+*   Initializes two arrays, adds each to the other and reduces both to a
+*   sum. Originally two sections serialized this behind locks (and
+*   deadlocked); here every phase is split across the whole team with
+*   "omp for simd", and the achieved GB/s are reported next to a
+*   STREAM-style triad so lock-serialized and bandwidth-bound runs can be
+*   told apart.
+*   Usage: Error2 [N] [repetitions]
 * AUTHOR: Blaise Barney  01/29/04
 * LAST REVISED: 04/06/05
 ******************************************************************************/
+#define _POSIX_C_SOURCE 200112L
+
 #include <omp.h>
 #include <stdio.h>
 #include <stdlib.h>
 #define N 1000000
+#define NTIMES 10
+#define ALIGNMENT 64
 #define PI 3.1415926535
 #define DELTA .01415926535
 
-int main (int argc, char *argv[]) 
+enum { TRIAD, INIT, ADD, SUM, NPHASES };
+
+static const char *phase_names[NPHASES] = { "triad", "init", "add", "sum" };
+/* Bytes touched per element, counted like STREAM (no write-allocate) */
+static const int phase_bytes[NPHASES] = { 3 * sizeof(float), 2 * sizeof(float),
+                                          6 * sizeof(float), 2 * sizeof(float) };
+
+float *alloc_vector(long n);
+
+int main (int argc, char *argv[])
 {
-int nthreads, tid, i;
-float a[N], b[N];
-omp_lock_t locka, lockb;
+int nthreads, k, p, ntimes = NTIMES;
+long i, n = N;
+float *a, *b, *c;
+double t, sum_a = 0.0, sum_b = 0.0, best[NPHASES];
 
-/* Initialize the locks */
-omp_init_lock(&locka);
-omp_init_lock(&lockb);
+if (argc > 1)
+  n = atol(argv[1]);
+if (argc > 2)
+  ntimes = atoi(argv[2]);
+if (n <= 0)
+  n = N;
+if (ntimes <= 0)
+  ntimes = NTIMES;
 
-/* Fork a team of threads giving them their own copies of variables */
-#pragma omp parallel shared(a, b, nthreads, locka, lockb) private(tid)
-  {
+a = alloc_vector(n);
+b = alloc_vector(n);
+c = alloc_vector(n);
+
+for (p = 0; p < NPHASES; p++)
+  best[p] = 1.0e30;
 
-  /* Obtain thread number and number of threads */
-  tid = omp_get_thread_num();
+#pragma omp parallel shared(a, b, c, nthreads)
+  {
   #pragma omp master
     {
     nthreads = omp_get_num_threads();
     printf("Number of threads = %d\n", nthreads);
+    printf("Vector length = %ld, best of %d runs\n", n, ntimes);
+    }
+
+  /* First touch with the same static schedule as the kernels */
+  #pragma omp for simd schedule(static)
+  for (i=0; i<n; i++)
+    a[i] = b[i] = c[i] = 0.0f;
+  }
+
+for (k = 0; k < ntimes; k++) {
+  /* STREAM triad as bandwidth baseline */
+  t = omp_get_wtime();
+  #pragma omp parallel for simd schedule(static)
+  for (i=0; i<n; i++)
+    c[i] = a[i] + (float) PI * b[i];
+  t = omp_get_wtime() - t;
+  if (t < best[TRIAD]) best[TRIAD] = t;
+
+  t = omp_get_wtime();
+  #pragma omp parallel for simd schedule(static)
+  for (i=0; i<n; i++) {
+    a[i] = i * DELTA;
+    b[i] = i * PI;
     }
-  printf("Thread %d starting...\n", tid);
-  #pragma omp barrier
+  t = omp_get_wtime() - t;
+  if (t < best[INIT]) best[INIT] = t;
 
-  #pragma omp sections nowait
+  /* b += a, then a += b; the implicit barrier orders the two updates */
+  t = omp_get_wtime();
+  #pragma omp parallel
     {
-    #pragma omp section
-      {
-      printf("Thread %d initializing a[]\n",tid);
-      omp_set_lock(&locka);
-      for (i=0; i<N; i++)
-        a[i] = i * DELTA;
-			omp_unset_lock(&locka);
-
-      omp_set_lock(&locka);
-			omp_set_lock(&lockb);
-      printf("Thread %d adding a[] to b[]\n",tid);
-      for (i=0; i<N; i++)
-        b[i] += a[i];
-      omp_unset_lock(&lockb);
-      omp_unset_lock(&locka);
-      }
-
-    #pragma omp section
-      {
-      printf("Thread %d initializing b[]\n",tid);
-      omp_set_lock(&lockb);
-      for (i=0; i<N; i++)
-        b[i] = i * PI;
-			omp_unset_lock(&lockb);
-
-      omp_set_lock(&locka);
-			omp_set_lock(&lockb);
-      printf("Thread %d adding b[] to a[]\n",tid);
-      for (i=0; i<N; i++)
-        a[i] += b[i];
-      omp_unset_lock(&lockb);
-      omp_unset_lock(&locka);
-      }
-    }  /* end of sections */
-  }  /* end of parallel region */
+    #pragma omp for simd schedule(static)
+    for (i=0; i<n; i++)
+      b[i] += a[i];
+    #pragma omp for simd schedule(static)
+    for (i=0; i<n; i++)
+      a[i] += b[i];
+    }
+  t = omp_get_wtime() - t;
+  if (t < best[ADD]) best[ADD] = t;
+
+  sum_a = sum_b = 0.0;
+  t = omp_get_wtime();
+  #pragma omp parallel for simd schedule(static) reduction(+:sum_a, sum_b)
+  for (i=0; i<n; i++) {
+    sum_a += a[i];
+    sum_b += b[i];
+    }
+  t = omp_get_wtime() - t;
+  if (t < best[SUM]) best[SUM] = t;
+  }
 
+printf("sum(a) = %e, sum(b) = %e\n", sum_a, sum_b);
+for (p = 0; p < NPHASES; p++) {
+  double rate = (double) phase_bytes[p] * n / best[p];
+  double baseline = 3.0 * sizeof(float) * n / best[TRIAD];
+  printf("%-6s %10.3f ms %10.2f GB/s %7.1f%% of triad\n",
+         phase_names[p], best[p] * 1000.0, rate * 1.0e-9, 100.0 * rate / baseline);
+  }
+
+free(a);
+free(b);
+free(c);
+return 0;
 }
 
+
+
+float *alloc_vector(long n)
+{
+  void *p;
+
+  if (posix_memalign(&p, ALIGNMENT, n * sizeof(float)) != 0) {
+    fprintf(stderr, "ERROR: Could not allocate %ld floats\n", n);
+    exit(1);
+    }
+  return p;
+}
@@ -0,0 +1,276 @@
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <omp.h>
+#include "mpi.h"
+
+#define TIMING_NOW() MPI_Wtime()
+#include "timing.h"
+#include "rules.h"
+#include "partition.h"
+
+#define calcIndex(width, x, y)  ((y)*(width) + (x))
+
+/*
+ * Hybrid MPI + OpenMP Game of Life.
+ *
+ * The board is split into row partitions, one per rank, and every rank
+ * evolves its rows with OpenMP threads. Partitions live in an MPI-3 shared
+ * memory window per node, so a rank whose neighbour sits on the same node
+ * reads the neighbour's boundary row in place through a row pointer.
+ * Only neighbours on other nodes exchange ghost rows via messages.
+ *
+ * Each rank's window segment holds two fields (current and next) of
+ * proc_height + 2 rows; the field that is current alternates with the time
+ * step, identically on all ranks.
+ */
+
+typedef bool (*evolve_fn)(const char **rows, char *new_field, int height, int width, rule_t rule);
+
+bool evolve(const char **rows, char *new_field, int height, int width, rule_t rule);
+
+evolve_fn select_evolve(rule_t rule);
+
+static char *field_of(char *segment, int parity, int proc_height, int width) {
+    return segment + (size_t) parity * (proc_height + 2) * width;
+}
+
+// seed 0 picks a time based seed
+void init_field(int rank, unsigned seed, char *current_field, int length) {
+    srand(seed ? seed + rank : rank * time(NULL));
+    for (int i = 0; i < length; i++) {
+        current_field[i] = (char) ((rand() < RAND_MAX / 10) ? 1 : 0);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    int provided;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
+    if (provided < MPI_THREAD_FUNNELED) {
+        fprintf(stderr, "ERROR: MPI library does not support MPI_THREAD_FUNNELED\n");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    int comm_world_size;
+    MPI_Comm_size(MPI_COMM_WORLD, &comm_world_size);
+
+    // ----- Create own gol communicator -----
+    MPI_Comm comm_gol;
+    int dims = {comm_world_size};
+    int periods = {true};
+    MPI_Cart_create(MPI_COMM_WORLD, 1, &dims, &periods, false, &comm_gol);
+
+    int comm_gol_rank, comm_gol_size;
+    MPI_Comm_size(comm_gol, &comm_gol_size);
+    MPI_Comm_rank(comm_gol, &comm_gol_rank);
+
+    int previous_neighbour, next_neighbour;
+    MPI_Cart_shift(comm_gol, 0, 1, &previous_neighbour, &next_neighbour);
+
+    // ----- Parse Inputs -----
+    int height = 30, width = 0, steps = 100, positional = 0;
+    char *timing_filename = NULL;
+    bool shared = true;
+    rule_t rule = RULE_CONWAY;
+    unsigned seed = 0;
+
+    for (int argumentnr = 1; argumentnr < argc; ++argumentnr) {
+        if (strcmp(argv[argumentnr], "--timing") == 0 && argumentnr + 1 < argc) {
+            timing_filename = argv[++argumentnr];
+        } else if (strcmp(argv[argumentnr], "--no-shared") == 0) {
+            // Exchange all ghost rows via messages, for comparison
+            shared = false;
+        } else if (strcmp(argv[argumentnr], "--steps") == 0 && argumentnr + 1 < argc) {
+            steps = atoi(argv[++argumentnr]);
+        } else if (strcmp(argv[argumentnr], "--seed") == 0 && argumentnr + 1 < argc) {
+            seed = (unsigned) atol(argv[++argumentnr]);
+        } else if (strcmp(argv[argumentnr], "--rule") == 0 && argumentnr + 1 < argc) {
+            if (rule_parse(argv[++argumentnr], &rule) != 0) {
+                if (comm_gol_rank == 0) fprintf(stderr, "ERROR: Invalid rule %s, expected B.../S...\n", argv[argumentnr]);
+                MPI_Finalize();
+                return 1;
+            }
+        } else if (positional == 0) {
+            height = atoi(argv[argumentnr]);
+            positional++;
+        } else if (positional == 1) {
+            width = atoi(argv[argumentnr]);
+            positional++;
+        }
+    }
+    if (width <= 0) width = height;
+    if (height < comm_gol_size) {
+        if (comm_gol_rank == 0) fprintf(stderr, "ERROR: Need at least one row per rank (%d < %d)\n", height, comm_gol_size);
+        MPI_Finalize();
+        return 1;
+    }
+
+    // ----- Node local communicator and shared window -----
+    MPI_Comm comm_node;
+    MPI_Comm_split_type(comm_gol, MPI_COMM_TYPE_SHARED, comm_gol_rank, MPI_INFO_NULL, &comm_node);
+
+    int proc_height = rows_for(comm_gol_rank, comm_gol_size, height);
+    MPI_Aint segment_size = (MPI_Aint) 2 * (proc_height + 2) * width;
+
+    // Non contiguous segments let every rank's pages land on its own NUMA domain
+    MPI_Info info;
+    MPI_Info_create(&info);
+    MPI_Info_set(info, "alloc_shared_noncontig", "true");
+    char *segment;
+    MPI_Win win;
+    MPI_Win_allocate_shared(segment_size, 1, info, comm_node, &segment, &win);
+    MPI_Info_free(&info);
+
+    // ----- Find neighbours on the same node -----
+    MPI_Group group_gol, group_node;
+    MPI_Comm_group(comm_gol, &group_gol);
+    MPI_Comm_group(comm_node, &group_node);
+    int neighbours[2] = {previous_neighbour, next_neighbour}, node_neighbours[2];
+    MPI_Group_translate_ranks(group_gol, 2, neighbours, group_node, node_neighbours);
+    MPI_Group_free(&group_gol);
+    MPI_Group_free(&group_node);
+
+    char *neighbour_segments[2] = {NULL, NULL};
+    int neighbour_heights[2];
+    for (int n = 0; n < 2; ++n) {
+        neighbour_heights[n] = rows_for(neighbours[n], comm_gol_size, height);
+        if (shared && node_neighbours[n] != MPI_UNDEFINED) {
+            MPI_Aint size;
+            int disp_unit;
+            MPI_Win_shared_query(win, node_neighbours[n], &size, &disp_unit, &neighbour_segments[n]);
+        }
+    }
+
+    printf("[INIT] Process %d of %d with %d threads: rows %d-%d of %dx%d, previous rank %d (%s), next rank %d (%s)\n",
+           comm_gol_rank, comm_gol_size, omp_get_max_threads(), first_row_for(comm_gol_rank, comm_gol_size, height),
+           first_row_for(comm_gol_rank, comm_gol_size, height) + proc_height - 1, height, width,
+           previous_neighbour, neighbour_segments[0] ? "shared" : "mpi",
+           next_neighbour, neighbour_segments[1] ? "shared" : "mpi");
+
+    evolve_fn evolve_kernel = select_evolve(rule);
+    const char **rows = malloc((proc_height + 2) * sizeof(char *));
+    memset(segment, 0, (size_t) segment_size);
+    init_field(comm_gol_rank, seed, field_of(segment, 0, proc_height, width) + width, proc_height * width);
+
+    // Passive target epoch for the whole run; MPI_Win_sync plus the per step
+    // collective order the direct loads and stores between ranks
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, win);
+    MPI_Win_sync(win);
+    MPI_Barrier(comm_node);
+    MPI_Win_sync(win);
+
+    long long halo_mpi_bytes = 0, halo_shared_bytes = 0;
+    phase_timer_t timer = {0};
+    bool run = true;
+    int i = 0;
+    double start = MPI_Wtime();
+    for (; run && i < steps; ++i) {
+        int parity = i % 2;
+        char *current_field = field_of(segment, parity, proc_height, width);
+        char *next_field = field_of(segment, 1 - parity, proc_height, width);
+
+        // ----- Ghost rows: pointers into neighbour memory or messages -----
+        timer_start(&timer);
+        for (int y = 0; y < proc_height + 2; ++y) {
+            rows[y] = current_field + y * width;
+        }
+        MPI_Request requests[4];
+        int request_count = 0;
+        if (neighbour_segments[0] != NULL) {
+            rows[0] = field_of(neighbour_segments[0], parity, neighbour_heights[0], width) + neighbour_heights[0] * width;
+            halo_shared_bytes += width;
+        } else {
+            MPI_Irecv(current_field, width, MPI_CHAR, previous_neighbour, 1000, comm_gol, &requests[request_count++]);
+            MPI_Isend(current_field + width, width, MPI_CHAR, previous_neighbour, 2000, comm_gol, &requests[request_count++]);
+            halo_mpi_bytes += width;
+        }
+        if (neighbour_segments[1] != NULL) {
+            rows[proc_height + 1] = field_of(neighbour_segments[1], parity, neighbour_heights[1], width) + width;
+            halo_shared_bytes += width;
+        } else {
+            MPI_Irecv(current_field + (proc_height + 1) * width, width, MPI_CHAR, next_neighbour, 2000, comm_gol,
+                      &requests[request_count++]);
+            MPI_Isend(current_field + proc_height * width, width, MPI_CHAR, next_neighbour, 1000, comm_gol,
+                      &requests[request_count++]);
+            halo_mpi_bytes += width;
+        }
+        MPI_Waitall(request_count, requests, MPI_STATUSES_IGNORE);
+        timer_stop(&timer, PHASE_HALO);
+
+        // ----- evolve -----
+        timer_start(&timer);
+        bool change = evolve_kernel(rows, next_field, proc_height, width, rule);
+        timer_stop(&timer, PHASE_EVOLVE);
+
+        // ----- exchange change, also orders this step's writes before the next step's reads -----
+        timer_start(&timer);
+        MPI_Win_sync(win);
+        MPI_Allreduce(&change, &run, 1, MPI_C_BOOL, MPI_LOR, comm_gol);
+        MPI_Win_sync(win);
+        timer_stop(&timer, PHASE_CONVERGENCE);
+    }
+    double elapsed = MPI_Wtime() - start, max_elapsed;
+    MPI_Win_unlock_all(win);
+
+    long long population = 0, total_population;
+    char *final_field = field_of(segment, i % 2, proc_height, width);
+    for (int j = width; j < (proc_height + 1) * width; ++j) {
+        population += final_field[j];
+    }
+
+    // ----- Summary -----
+    long long local_bytes[2] = {halo_mpi_bytes, halo_shared_bytes}, total_bytes[2];
+    MPI_Reduce(local_bytes, total_bytes, 2, MPI_LONG_LONG, MPI_SUM, 0, comm_gol);
+    MPI_Reduce(&elapsed, &max_elapsed, 1, MPI_DOUBLE, MPI_MAX, 0, comm_gol);
+    MPI_Reduce(&population, &total_population, 1, MPI_LONG_LONG, MPI_SUM, 0, comm_gol);
+
+    double *totals = comm_gol_rank == 0 ? malloc(comm_gol_size * PHASE_COUNT * sizeof(double)) : NULL;
+    MPI_Gather(timer.total, PHASE_COUNT, MPI_DOUBLE, totals, PHASE_COUNT, MPI_DOUBLE, 0, comm_gol);
+    if (comm_gol_rank == 0) {
+        printf("Finished after %d steps\n", i);
+        printf("Average wall time: %.3f ms\n", max_elapsed * 1000.0 / i);
+        printf("Population: %lld\n", total_population);
+        printf("Halo traffic: %lld bytes via messages, %lld bytes read from shared memory\n",
+               total_bytes[0], total_bytes[1]);
+        timing_print(stdout, "rank", totals, comm_gol_size, i);
+        if (timing_filename != NULL) {
+            timing_write(timing_filename, "rank", totals, comm_gol_size, i);
+        }
+        free(totals);
+    }
+
+    free(rows);
+    MPI_Win_free(&win);
+    MPI_Comm_free(&comm_node);
+    MPI_Finalize();
+    return 0;
+}
+
+// Kernel body for RULE_DEFINE_KERNELS.
+// rows holds height + 2 row pointers including the ghost rows, columns wrap around.
+static inline __attribute__((always_inline)) bool
+evolve_rule(unsigned birth, unsigned survive, const char **rows, char *new_field, int height, int width) {
+    bool change = false;
+#pragma omp parallel for schedule(static) reduction(||:change)
+    for (int y = 1; y <= height; ++y) {
+        const char *above = rows[y - 1], *row = rows[y], *below = rows[y + 1];
+        char *new_row = new_field + calcIndex(width, 0, y);
+        for (int x = 0; x < width; ++x) {
+            int left = x == 0 ? width - 1 : x - 1;
+            int right = x == width - 1 ? 0 : x + 1;
+            int neighbours = above[left] + above[x] + above[right] + row[left] + row[right] + below[left] +
+                             below[x] + below[right];
+            new_row[x] = RULE_NEXT(birth, survive, row[x], neighbours);
+            change = change || new_row[x] != row[x];
+        }
+    }
+    return change;
+}
+
+RULE_DEFINE_KERNELS(evolve_fn, select_evolve, evolve, evolve_rule,
+                    (const char **rows, char *new_field, int height, int width, rule_t rule),
+                    (rows, new_field, height, width))
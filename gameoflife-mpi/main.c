@@ -1,3 +1,5 @@
+#define _GNU_SOURCE
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
@@ -5,18 +7,161 @@
 #include <memory.h>
 #include "mpi.h"
 
+#define TIMING_NOW() MPI_Wtime()
+#include "timing.h"
+#include "perf_counters.h"
+#include "rules.h"
+#include "partition.h"
+#include "analytics.h"
+#include "ltl.h"
+
 #define calcIndex(width, x, y)  ((y)*(width) + (x))
 
+// Ghost layer exchange: two-sided messages, or one-sided puts synchronized by fences or PSCW
+typedef enum {
+    HALO_P2P,
+    HALO_FENCE,
+    HALO_PSCW
+} halo_mode_t;
+
+// stats may be NULL; otherwise the kernel adds the analytics of its block to it
+typedef bool (*evolve_fn)(const char *current_field, char *new_field, int block_width, int block_height, int width,
+                          int height, int offset_x, int offset_y, rule_t rule, step_stats_t *stats);
+
 bool evolve(const char *current_field, char *new_field, int block_width, int block_height, int width,
-            int height, int offset_x, int offset_y);
+            int height, int offset_x, int offset_y, rule_t rule, step_stats_t *stats);
+
+// Combines the stats of all ranks, every rank gets the result
+static void stats_allreduce(step_stats_t *stats, MPI_Comm comm) {
+    long sums[3 + ANALYTICS_BINS] = {stats->population, stats->births, stats->deaths};
+    memcpy(&sums[3], stats->histogram, sizeof(stats->histogram));
+    // Maxima negated so one MPI_MIN covers the whole bounding box
+    long box[4] = {stats->min_x, stats->min_y, -(long) stats->max_x, -(long) stats->max_y};
+
+    MPI_Allreduce(MPI_IN_PLACE, sums, 3 + ANALYTICS_BINS, MPI_LONG, MPI_SUM, comm);
+    MPI_Allreduce(MPI_IN_PLACE, &stats->hash, 1, MPI_UINT64_T, MPI_SUM, comm);
+    MPI_Allreduce(MPI_IN_PLACE, box, 4, MPI_LONG, MPI_MIN, comm);
+
+    stats->population = sums[0];
+    stats->births = sums[1];
+    stats->deaths = sums[2];
+    memcpy(stats->histogram, &sums[3], sizeof(stats->histogram));
+    stats->min_x = (int) box[0];
+    stats->min_y = (int) box[1];
+    stats->max_x = (int) -box[2];
+    stats->max_y = (int) -box[3];
+}
+
+evolve_fn select_evolve(rule_t rule);
+
+// Rebalance only if the slowest rank is more than this fraction above the average
+#define BALANCE_TOLERANCE 0.05
+
+// Moves the partition boundaries so that the measured evolve cost is split evenly, assuming every row of a
+// rank costs the same. A boundary moves by at most half the rows of the rank that gives them away, so rows
+// only travel between direct neighbours. Returns false if the partition stays as it is.
+static bool balance_rows(const int *first_row, const double *cost, int size, int min_rows, int *new_first_row) {
+    double total = 0, max = 0;
+    for (int r = 0; r < size; ++r) {
+        total += cost[r];
+        if (cost[r] > max) max = cost[r];
+    }
+    if (total <= 0 || max <= (1.0 + BALANCE_TOLERANCE) * total / size) return false;
+
+    new_first_row[0] = first_row[0];
+    new_first_row[size] = first_row[size];
+    int rank = 0;
+    double before = 0;
+    for (int k = 1; k < size; ++k) {
+        double target = total * k / size;
+        while (rank < size - 1 && before + cost[rank] < target) {
+            before += cost[rank];
+            rank++;
+        }
+        double row_cost = cost[rank] / (first_row[rank + 1] - first_row[rank]);
+        int boundary = first_row[rank] + (row_cost > 0 ? (int) ((target - before) / row_cost + 0.5) : 0);
+
+        int low = first_row[k] - (first_row[k] - first_row[k - 1]) / 2;
+        int high = first_row[k] + (first_row[k + 1] - first_row[k]) / 2;
+        new_first_row[k] = boundary < low ? low : boundary > high ? high : boundary;
+    }
+
+    // Keep min_rows per rank by putting offending boundaries back; all old boundaries are valid
+    bool fixed;
+    do {
+        fixed = false;
+        for (int k = 1; k < size; ++k) {
+            if (new_first_row[k] != first_row[k] && (new_first_row[k] - new_first_row[k - 1] < min_rows ||
+                                                     new_first_row[k + 1] - new_first_row[k] < min_rows)) {
+                new_first_row[k] = first_row[k];
+                fixed = true;
+            }
+        }
+    } while (fixed);
+
+    for (int k = 1; k < size; ++k) {
+        if (new_first_row[k] != first_row[k]) return true;
+    }
+    return false;
+}
+
+// Hands rows to or takes rows from the direct neighbours for the new partition. Returns a new fields block
+// holding the current generation in its first field; field_length is updated.
+static char *move_rows(const char *current_field, const int *first_row, const int *new_first_row, int rank,
+                       int ghost, int width, MPI_Comm comm, size_t *field_length) {
+    int old_first = first_row[rank], old_last = first_row[rank + 1];
+    int new_first = new_first_row[rank], new_last = new_first_row[rank + 1];
+    *field_length = (size_t) (new_last - new_first + 2 * ghost) * width;
+    char *fields = calloc(2 * *field_length, sizeof(char));
+
+    // Global row y lives at row y - first + ghost of a field
+    int keep_first = old_first > new_first ? old_first : new_first;
+    int keep_last = old_last < new_last ? old_last : new_last;
+    if (keep_last > keep_first) {
+        memcpy(fields + (size_t) (keep_first - new_first + ghost) * width,
+               current_field + (size_t) (keep_first - old_first + ghost) * width,
+               (size_t) (keep_last - keep_first) * width);
+    }
+
+    // Rank 0 always starts at row 0 and the last rank ends at the last row, so nothing wraps around
+    MPI_Request requests[2];
+    int count = 0;
+    if (new_first < old_first) {
+        MPI_Irecv(fields + (size_t) ghost * width, (old_first - new_first) * width, MPI_CHAR, rank - 1, 3000, comm,
+                  &requests[count++]);
+    } else if (new_first > old_first) {
+        MPI_Isend(current_field + (size_t) ghost * width, (new_first - old_first) * width, MPI_CHAR, rank - 1, 4000,
+                  comm, &requests[count++]);
+    }
+    if (new_last > old_last) {
+        MPI_Irecv(fields + (size_t) (old_last - new_first + ghost) * width, (new_last - old_last) * width, MPI_CHAR,
+                  rank + 1, 4000, comm, &requests[count++]);
+    } else if (new_last < old_last) {
+        MPI_Isend(current_field + (size_t) (new_last - old_first + ghost) * width, (old_last - new_last) * width,
+                  MPI_CHAR, rank + 1, 3000, comm, &requests[count++]);
+    }
+    MPI_Waitall(count, requests, MPI_STATUSES_IGNORE);
+    return fields;
+}
+
+static MPI_Win create_window(char *fields, size_t field_length, MPI_Comm comm) {
+    MPI_Win win;
+    MPI_Info info;
+    MPI_Info_create(&info);
+    MPI_Info_set(info, "no_locks", "true");
+    MPI_Win_create(fields, (MPI_Aint) (2 * field_length), 1, info, comm, &win);
+    MPI_Info_free(&info);
+    return win;
+}
 
 void writeVTK(char *filename, const char *field, int block_width, int block_height, int total_width, int total_height,
            int offset_x, int offset_y);
 
 int count_living_neighbours(const char *field, int x, int y, int width, int height) ;
 
-void *init_field(int rank, char *current_field, int length) {
-    srand(rank*time(NULL));
+// seed 0 picks a time based seed
+void init_field(int rank, unsigned seed, char *current_field, int length) {
+    srand(seed ? seed + rank : rank*time(NULL));
     for (int i = 0; i < length; i++) {
         current_field[i] = (char) ((rand() < RAND_MAX / 10) ? 1 : 0);
     }
@@ -48,75 +193,259 @@ int main(int argc, char *argv[]) {
 
 
     // ----- Parse Inputs -----
-    int height = 30, width, argumentnr = 1;
-
-    // Parse Height
-    if(argumentnr < argc){
-        height = atoi(argv[argumentnr]);
-        argumentnr++;
+    int height = 30, width = 0, positional = 0;
+    char *timing_filename = NULL;
+    bool perf = false;
+    bool write = true;
+    rule_t rule = RULE_CONWAY;
+    bool ltl = false;
+    bool rule_given = false;
+    ltl_rule_t ltl_rule;
+    halo_mode_t halo = HALO_P2P;
+    unsigned seed = 0;
+    int balance_every = 0;
+    char *analytics_filename = NULL;
+    int frame_every = 0;
+    double frame_trigger = 0.0;
+
+    for (int argumentnr = 1; argumentnr < argc; ++argumentnr) {
+        if (strcmp(argv[argumentnr], "--timing") == 0 && argumentnr + 1 < argc) {
+            timing_filename = argv[++argumentnr];
+        } else if (strcmp(argv[argumentnr], "--perf") == 0) {
+            perf = true;
+        } else if (strcmp(argv[argumentnr], "--no-write") == 0) {
+            write = false;
+        } else if (strcmp(argv[argumentnr], "--ltl") == 0 && argumentnr + 1 < argc) {
+            if (ltl_parse(argv[++argumentnr], &ltl_rule) != 0) {
+                if (comm_world_rank == 0) fprintf(stderr, "ERROR: Invalid Larger than Life rule %s, expected e.g. R5,C2,M1,S34..58,B34..45,NM\n", argv[argumentnr]);
+                MPI_Finalize();
+                return 1;
+            }
+            ltl = true;
+        } else if (strcmp(argv[argumentnr], "--analytics") == 0 && argumentnr + 1 < argc) {
+            analytics_filename = argv[++argumentnr];
+        } else if (strcmp(argv[argumentnr], "--frame-every") == 0 && argumentnr + 1 < argc) {
+            frame_every = atoi(argv[++argumentnr]);
+        } else if (strcmp(argv[argumentnr], "--frame-trigger") == 0 && argumentnr + 1 < argc) {
+            frame_trigger = atof(argv[++argumentnr]);
+        } else if (strcmp(argv[argumentnr], "--balance") == 0 && argumentnr + 1 < argc) {
+            balance_every = atoi(argv[++argumentnr]);
+        } else if (strcmp(argv[argumentnr], "--seed") == 0 && argumentnr + 1 < argc) {
+            seed = (unsigned) atol(argv[++argumentnr]);
+        } else if (strcmp(argv[argumentnr], "--halo") == 0 && argumentnr + 1 < argc) {
+            argumentnr++;
+            if (strcmp(argv[argumentnr], "p2p") == 0) {
+                halo = HALO_P2P;
+            } else if (strcmp(argv[argumentnr], "fence") == 0) {
+                halo = HALO_FENCE;
+            } else if (strcmp(argv[argumentnr], "pscw") == 0) {
+                halo = HALO_PSCW;
+            } else {
+                if (comm_world_rank == 0) fprintf(stderr, "ERROR: Unknown halo mode %s, expected p2p, fence or pscw\n", argv[argumentnr]);
+                MPI_Finalize();
+                return 1;
+            }
+        } else if (strcmp(argv[argumentnr], "--rule") == 0 && argumentnr + 1 < argc) {
+            if (rule_parse(argv[++argumentnr], &rule) != 0) {
+                if (comm_world_rank == 0) fprintf(stderr, "ERROR: Invalid rule %s, expected B.../S...\n", argv[argumentnr]);
+                MPI_Finalize();
+                return 1;
+            }
+            rule_given = true;
+        } else if (positional == 0) {
+            // Parse Height
+            height = atoi(argv[argumentnr]);
+            positional++;
+        } else if (positional == 1) {
+            width = atoi(argv[argumentnr]);
+            positional++;
+        }
     }
 
     // Parse Width - if not existing: set width equal to height
-    width = argumentnr < argc ? atoi(argv[argumentnr]) : height;
+    if (width <= 0) width = height;
 
     // -----  -----
-    int total_length = height * width;
-    int proc_height = height / comm_gol_size;
+    // Partition boundaries of all ranks, rank r owns rows first_row[r] .. first_row[r + 1] - 1
+    int *first_row = malloc((comm_gol_size + 1) * sizeof(int));
+    int *new_first_row = malloc((comm_gol_size + 1) * sizeof(int));
+    for (int r = 0; r <= comm_gol_size; ++r) {
+        first_row[r] = first_row_for(r, comm_gol_size, height);
+    }
+    int proc_height = rows_for(comm_gol_rank, comm_gol_size, height);
     int proc_area = proc_height * width;
-    int offset = proc_area * comm_gol_rank;
+    int offset = first_row[comm_gol_rank] * width;
+
+    // Larger than Life needs as many ghost rows as its radius, all of them from the direct neighbours
+    int ghost = ltl ? ltl_rule.radius : 1;
+    if (height / comm_gol_size < ghost) {
+        if (comm_gol_rank == 0) {
+            fprintf(stderr, "ERROR: %d rows are too few for %d ranks with %d ghost rows each\n", height,
+                    comm_gol_size, ghost);
+        }
+        MPI_Finalize();
+        return 1;
+    }
+    // perf counters only see the calling thread, but the Larger than Life kernel runs on all OpenMP threads
+    if (ltl && (analytics_filename != NULL || perf || rule_given)) {
+        if (comm_gol_rank == 0) fprintf(stderr, "ERROR: --ltl cannot be combined with --analytics, --perf or --rule\n");
+        MPI_Finalize();
+        return 1;
+    }
+    if (ltl && width < 2 * ghost + 1) {
+        if (comm_gol_rank == 0) {
+            fprintf(stderr, "ERROR: Radius %d needs at least %d columns\n", ghost, 2 * ghost + 1);
+        }
+        MPI_Finalize();
+        return 1;
+    }
 
     printf("[INIT] Process %d of %d started with size of %dx%d - assigned partition %d next rank: %d previous rank: %d\n",
            comm_gol_rank, comm_gol_size, height, width, offset,
            next_neighbour, previous_neighbour);
 
-    // Initialise fields
-    char *currentField = calloc((size_t) proc_area + 2 * width, sizeof(char));
-    char *nextField = calloc((size_t) proc_area + 2 * width, sizeof(char));
+    // Initialise fields, both in one block so a single window can expose their ghost rows
+    size_t field_length = (size_t) proc_area + 2 * ghost * width;
+    char *fields = calloc(2 * field_length, sizeof(char));
+    char *currentField = fields;
+    char *nextField = fields + field_length;
+
+    init_field(comm_gol_rank, seed, currentField + ghost * width, proc_area);
+    evolve_fn evolve_kernel = select_evolve(rule);
+    if (comm_gol_rank == 0 && ltl) {
+        printf("[INIT] Rule: R%d,C2,M%d,S%d..%d,B%d..%d,NM (Larger than Life)\n", ltl_rule.radius, ltl_rule.center,
+               ltl_rule.survive_min, ltl_rule.survive_max, ltl_rule.birth_min, ltl_rule.birth_max);
+    } else if (comm_gol_rank == 0) {
+        char rulestring[32];
+        rule_format(rule, rulestring, sizeof(rulestring));
+        printf("[INIT] Rule: %s (%s kernel)\n", rulestring, evolve_kernel == evolve ? "generic" : "specialized");
+    }
+    // ----- Window for one-sided halo exchange -----
+    MPI_Win win = MPI_WIN_NULL;
+    MPI_Group neighbour_group = MPI_GROUP_NULL;
+    if (halo != HALO_P2P) {
+        win = create_window(fields, field_length, comm_gol);
+
+        MPI_Group group_gol;
+        MPI_Comm_group(comm_gol, &group_gol);
+        int neighbour_ranks[2] = {previous_neighbour, next_neighbour};
+        MPI_Group_incl(group_gol, previous_neighbour == next_neighbour ? 1 : 2, neighbour_ranks, &neighbour_group);
+        MPI_Group_free(&group_gol);
+    }
+
+    // ----- In-situ analytics, only rank 0 writes the time series -----
+    bool analyse = analytics_filename != NULL;
+    analytics_t analytics;
+    if (analyse) {
+        analytics_open(&analytics, comm_gol_rank == 0 ? analytics_filename : NULL, frame_every, frame_trigger);
+    }
+    // With analytics, full frames are written only when analytics_record() asks for one
+    bool write_frame = write && !analyse;
+
+    double *costs = malloc(comm_gol_size * sizeof(double));
+    double balanced_evolve = 0;
 
-    init_field(comm_gol_rank, currentField + width, proc_area);
     bool run = true;
     int i = 0;
+    MPI_Barrier(comm_gol);
+    double start = MPI_Wtime();
+    phase_timer_t timer = {0};
+    perf_counters_t counters;
+    if (perf) {
+        perf_counters_open(&counters);
+    }
     for (; run && i < 100; ++i) {
 
         // ----- Exchange ghost layer -----
-        // Send to next neighbour
-        MPI_Request send_next_request;
-        char *send_next_buffer = currentField + proc_height * width;
-        MPI_Isend(send_next_buffer, width, MPI_CHAR, next_neighbour, 1000, comm_gol, &send_next_request);
-
-        // Send to previous neighbour
-        MPI_Request send_previous_request;
-        char *send_previous_buffer = currentField + width;
-        MPI_Isend(send_previous_buffer, width, MPI_CHAR, previous_neighbour, 2000, comm_gol, &send_previous_request);
-        //printf("[DEBUG P:%d] Invoked sending to: %d\n", comm_gol_rank, comm_gol_rank - 1 < 0 ? comm_gol_size - 1 : comm_gol_rank - 1);
-
-        // Receive from previous neighbour
-        MPI_Status receive_previous_status;
-        char *receive_previous_buffer = calloc((size_t) width, sizeof(char));
-        MPI_Recv(receive_previous_buffer, width, MPI_CHAR, previous_neighbour, 1000, comm_gol, &receive_previous_status);
-
-        memcpy(currentField, receive_previous_buffer, (size_t) width);
-
-        // Receive from next neighbour
-        MPI_Status receive_next_status;
-        char *receive_next_buffer = calloc((size_t) width, sizeof(char));
-        MPI_Recv(receive_next_buffer, width, MPI_CHAR, next_neighbour, 2000, comm_gol, &receive_next_status);
-        //printf("[DEBUG P:%d] Message received from %d\n", comm_gol_rank, comm_gol_rank + 1 >= comm_gol_size? 0 : comm_gol_rank + 1);
-
-        memcpy(currentField + ((proc_height + 1) * width), receive_next_buffer, (size_t) width);
+        timer_start(&timer);
+        if (halo != HALO_P2P) {
+            // Put own boundary rows straight into the neighbours' ghost rows of the same field.
+            // Partitions differ in height, so the offsets follow from the neighbours' row counts.
+            int parity = currentField == fields ? 0 : 1;
+            int previous_height = first_row[previous_neighbour + 1] - first_row[previous_neighbour];
+            int next_height = first_row[next_neighbour + 1] - first_row[next_neighbour];
+            MPI_Aint previous_disp = (MPI_Aint) (parity * (previous_height + 2 * ghost) + previous_height + ghost) * width;
+            MPI_Aint next_disp = (MPI_Aint) parity * (next_height + 2 * ghost) * width;
+            if (halo == HALO_FENCE) {
+                MPI_Win_fence(MPI_MODE_NOPRECEDE, win);
+            } else {
+                MPI_Win_post(neighbour_group, 0, win);
+                MPI_Win_start(neighbour_group, 0, win);
+            }
+            int halo_length = ghost * width;
+            MPI_Put(currentField + halo_length, halo_length, MPI_CHAR, previous_neighbour, previous_disp, halo_length,
+                    MPI_CHAR, win);
+            MPI_Put(currentField + proc_height * width, halo_length, MPI_CHAR, next_neighbour, next_disp, halo_length,
+                    MPI_CHAR, win);
+            if (halo == HALO_FENCE) {
+                MPI_Win_fence(MPI_MODE_NOSTORE | MPI_MODE_NOSUCCEED, win);
+            } else {
+                MPI_Win_complete(win);
+                MPI_Win_wait(win);
+            }
+        } else {
+            // Send to next neighbour
+            int halo_length = ghost * width;
+            MPI_Request send_next_request;
+            char *send_next_buffer = currentField + proc_height * width;
+            MPI_Isend(send_next_buffer, halo_length, MPI_CHAR, next_neighbour, 1000, comm_gol, &send_next_request);
+
+            // Send to previous neighbour
+            MPI_Request send_previous_request;
+            char *send_previous_buffer = currentField + halo_length;
+            MPI_Isend(send_previous_buffer, halo_length, MPI_CHAR, previous_neighbour, 2000, comm_gol, &send_previous_request);
+            //printf("[DEBUG P:%d] Invoked sending to: %d\n", comm_gol_rank, comm_gol_rank - 1 < 0 ? comm_gol_size - 1 : comm_gol_rank - 1);
+
+            // Receive from previous neighbour
+            MPI_Status receive_previous_status;
+            char *receive_previous_buffer = calloc((size_t) halo_length, sizeof(char));
+            MPI_Recv(receive_previous_buffer, halo_length, MPI_CHAR, previous_neighbour, 1000, comm_gol, &receive_previous_status);
+
+            memcpy(currentField, receive_previous_buffer, (size_t) halo_length);
+
+            // Receive from next neighbour
+            MPI_Status receive_next_status;
+            char *receive_next_buffer = calloc((size_t) halo_length, sizeof(char));
+            MPI_Recv(receive_next_buffer, halo_length, MPI_CHAR, next_neighbour, 2000, comm_gol, &receive_next_status);
+            //printf("[DEBUG P:%d] Message received from %d\n", comm_gol_rank, comm_gol_rank + 1 >= comm_gol_size? 0 : comm_gol_rank + 1);
+
+            memcpy(currentField + ((proc_height + ghost) * width), receive_next_buffer, (size_t) halo_length);
+            free(receive_previous_buffer);
+            free(receive_next_buffer);
+            MPI_Wait(&send_next_request, MPI_STATUS_IGNORE);
+            MPI_Wait(&send_previous_request, MPI_STATUS_IGNORE);
+        }
+        timer_stop(&timer, PHASE_HALO);
 
         // ----- Write VTK files -----
-        char thread_filename[2048];
-        snprintf(thread_filename, sizeof(thread_filename), "gol%d-%05d%s", comm_gol_rank, i, ".vti");
-        writeVTK(thread_filename, currentField + width, width, proc_height, width, height, 0, comm_gol_rank * proc_height);
+        if (write_frame) {
+            timer_start(&timer);
+            char thread_filename[2048];
+            snprintf(thread_filename, sizeof(thread_filename), "gol%d-%05d%s", comm_gol_rank, i, ".vti");
+            writeVTK(thread_filename, currentField + ghost * width, width, proc_height, width, height, 0, first_row[comm_gol_rank]);
+            timer_stop(&timer, PHASE_IO);
+        }
 
         // ----- evolve -----
-        bool change = evolve(currentField, nextField, width, proc_height, width, proc_height + 2, 0, 1);
+        step_stats_t stats;
+        stats_reset(&stats, first_row[comm_gol_rank] - 1);
+        timer_start(&timer);
+        if (perf) perf_counters_start(&counters);
+        bool change;
+        if (ltl) {
+            change = ltl_evolve(&ltl_rule, currentField, nextField + ghost * width, width, proc_height) != 0;
+        } else {
+            change = evolve_kernel(currentField, nextField, width, proc_height, width, proc_height + 2, 0, 1, rule,
+                                   analyse ? &stats : NULL);
+        }
+        if (perf) perf_counters_stop(&counters);
+        timer_stop(&timer, PHASE_EVOLVE);
         char *tmp = currentField;
         currentField = nextField;
         nextField = tmp;
 
         // ----- exchange change -----
+        timer_start(&timer);
         bool *send_change_buffer = calloc((size_t) 1, sizeof(bool));
         send_change_buffer[0] = change;
         bool *receive_change_buffer = calloc((size_t) comm_gol_size, sizeof(bool));
@@ -128,28 +457,136 @@ int main(int argc, char *argv[]) {
                 break;
             }
         }
+        free(send_change_buffer);
+        free(receive_change_buffer);
+        timer_stop(&timer, PHASE_CONVERGENCE);
+
+        if (analyse) {
+            timer_start(&timer);
+            stats_allreduce(&stats, comm_gol);
+            write_frame = analytics_record(&analytics, i, &stats) && write;
+            timer_stop(&timer, PHASE_ANALYTICS);
+        }
+
+        // ----- Rebalance partitions by the evolve time since the last rebalance -----
+        if (balance_every > 0 && comm_gol_size > 1 && run && (i + 1) % balance_every == 0) {
+            timer_start(&timer);
+            double cost = timer.total[PHASE_EVOLVE] - balanced_evolve;
+            balanced_evolve = timer.total[PHASE_EVOLVE];
+            MPI_Allgather(&cost, 1, MPI_DOUBLE, costs, 1, MPI_DOUBLE, comm_gol);
+            if (balance_rows(first_row, costs, comm_gol_size, ghost, new_first_row)) {
+                char *moved = move_rows(currentField, first_row, new_first_row, comm_gol_rank, ghost, width, comm_gol,
+                                        &field_length);
+                if (halo != HALO_P2P) {
+                    MPI_Win_free(&win);
+                    win = create_window(moved, field_length, comm_gol);
+                }
+                free(fields);
+                fields = moved;
+                currentField = fields;
+                nextField = fields + field_length;
+
+                int *tmp_rows = first_row;
+                first_row = new_first_row;
+                new_first_row = tmp_rows;
+                proc_height = first_row[comm_gol_rank + 1] - first_row[comm_gol_rank];
+                proc_area = proc_height * width;
+                if (comm_gol_rank == 0) {
+                    printf("[BALANCE] Step %d: partitions start at rows", i);
+                    for (int r = 0; r < comm_gol_size; ++r) {
+                        printf(" %d", first_row[r]);
+                    }
+                    printf("\n");
+                }
+            }
+            timer_stop(&timer, PHASE_BALANCE);
+        }
+    }
+    if (analyse) {
+        analytics_close(&analytics);
     }
 
+    double elapsed = MPI_Wtime() - start, max_elapsed;
     printf("[DEBUG P:%d] Finished after %d steps\n", comm_gol_rank, i);
+    long population = 0, total_population;
+    for (int j = ghost * width; j < proc_area + ghost * width; ++j) {
+        population += currentField[j];
+    }
+    MPI_Reduce(&elapsed, &max_elapsed, 1, MPI_DOUBLE, MPI_MAX, 0, comm_gol);
+    MPI_Reduce(&population, &total_population, 1, MPI_LONG, MPI_SUM, 0, comm_gol);
+    if (comm_gol_rank == 0) {
+        printf("Average wall time: %.3f ms\n", max_elapsed * 1000.0 / i);
+        printf("Population: %ld\n", total_population);
+    }
+
+    // ----- Gather timings -----
+    double *totals = comm_gol_rank == 0 ? malloc(comm_gol_size * PHASE_COUNT * sizeof(double)) : NULL;
+    MPI_Gather(timer.total, PHASE_COUNT, MPI_DOUBLE, totals, PHASE_COUNT, MPI_DOUBLE, 0, comm_gol);
+    if (comm_gol_rank == 0) {
+        timing_print(stdout, "rank", totals, comm_gol_size, i);
+        if (timing_filename != NULL) {
+            timing_write(timing_filename, "rank", totals, comm_gol_size, i);
+        }
+        free(totals);
+    }
+
+    // ----- Reduce hardware counters -----
+    if (perf) {
+        perf_counters_t perf_total;
+        perf_counters_close(&counters);
+        MPI_Reduce(counters.value, perf_total.value, PERF_EVENT_COUNT, MPI_UINT64_T, MPI_SUM, 0, comm_gol);
+        MPI_Reduce(counters.available, perf_total.available, PERF_EVENT_COUNT, MPI_INT, MPI_MIN, 0, comm_gol);
+        if (comm_gol_rank == 0) {
+            perf_counters_print(stdout, &perf_total, (double) width * height * i);
+        }
+    }
+
+    if (halo != HALO_P2P) {
+        MPI_Group_free(&neighbour_group);
+        MPI_Win_free(&win);
+    }
+    free(fields);
+    free(first_row);
+    free(new_first_row);
+    free(costs);
 
     MPI_Finalize();
     return 0;
 }
 
-bool evolve(const char *current_field, char *new_field, int block_width, int block_height, int total_width,
-            int total_height, int offset_x, int offset_y) {
+// Kernel body for RULE_DEFINE_KERNELS
+static inline __attribute__((always_inline)) bool
+evolve_rule(unsigned birth, unsigned survive, const char *current_field, char *new_field, int block_width,
+            int block_height, int total_width, int total_height, int offset_x, int offset_y, step_stats_t *stats) {
+    // Counted in a local copy, new_field stores may alias *stats
+    step_stats_t local;
+    if (stats != NULL) {
+        stats_reset(&local, stats->origin_y);
+    }
     bool change = false;
     for (int y = offset_y; y < offset_y + block_height; ++y) {
         for (int x = offset_x; x < offset_x + block_width; ++x) {
             int index = calcIndex(total_width, x, y);
             int neighbours = count_living_neighbours(current_field, x, y, total_width, total_height);
-            new_field[index] = (neighbours == 3 || (neighbours == 2 && current_field[index]));
+            new_field[index] = RULE_NEXT(birth, survive, current_field[index], neighbours);
             if(!change && new_field[index] != current_field[index]) change = true;
+            if (stats != NULL) {
+                stats_add_cell(&local, x, y, total_width, current_field[index], new_field[index], neighbours);
+            }
         }
     }
+    if (stats != NULL) {
+        stats_merge(stats, &local);
+    }
     return change;
 }
 
+RULE_DEFINE_KERNELS(evolve_fn, select_evolve, evolve, evolve_rule,
+                    (const char *current_field, char *new_field, int block_width, int block_height, int total_width,
+                     int total_height, int offset_x, int offset_y, rule_t rule, step_stats_t *stats),
+                    (current_field, new_field, block_width, block_height, total_width, total_height, offset_x,
+                     offset_y, stats))
+
 int count_living_neighbours(const char *field, int x, int y, int width, int height) {
     int number = 0;
     for (int iy = y - 1; iy <= y + 1; iy++) {
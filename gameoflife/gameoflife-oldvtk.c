@@ -1,117 +1,162 @@
+#define _GNU_SOURCE
+
 #include <stdio.h>
 #include <stdlib.h>
-#include <unistd.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
 #include <endian.h>
 #include <omp.h>
 
+#include "render.h"
+
 #define calcIndex(width, x,y)  ((y)*(width) + (x))
 
-void show(unsigned* currentfield, int w, int h) {
-  printf("\033[H");
-  for (int y = 0; y < h; y++) {
-    for (int x = 0; x < w; x++) printf(currentfield[calcIndex(w, x,y)] ? "\033[07m  \033[m" : "  ");
-    printf("\033[E");
+// One byte per cell, 0 or 1
+typedef char cell_t;
+
+// Legacy VTK wants big-endian floats: convert the whole field into one buffer, one fwrite per frame
+void convert2BigEndian(const cell_t* currentfield, uint32_t* buffer, int n) {
+#pragma omp parallel for simd
+  for (int i = 0; i < n; i++) {
+    float value = currentfield[i];
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    buffer[i] = htobe32(bits);
   }
-  fflush(stdout);
 }
 
+void writeHeader(FILE* outfile, int w, int h, const char* title) {
+  /*Write vtk header */
+  fprintf(outfile,"# vtk DataFile Version 3.0\n");
+  fprintf(outfile,"%s\n", title);
+  fprintf(outfile,"BINARY\n");
+  fprintf(outfile,"DATASET STRUCTURED_POINTS\n");
+  fprintf(outfile,"DIMENSIONS %d %d %d \n", w, h, 1);
+  fprintf(outfile,"SPACING 1.0 1.0 1.0\n");//or ASPECT_RATIO
+  fprintf(outfile,"ORIGIN 0 0 0\n");
+  fprintf(outfile,"POINT_DATA %d\n", h*w);
+}
 
-float convert2BigEndian( const float inFloat )
-{
-   float retVal;
-   char *floatToConvert = ( char* ) & inFloat;
-   char *returnFloat    = ( char* ) & retVal;
-
-   // swap the bytes into a temporary buffer
-   returnFloat[0] = floatToConvert[3];
-   returnFloat[1] = floatToConvert[2];
-   returnFloat[2] = floatToConvert[1];
-   returnFloat[3] = floatToConvert[0];
-
-   return retVal;
+// Appends the field as scalar array name; the stream file names one array per step, so it can hold any number
+void writeScalars(FILE* outfile, const cell_t* currentfield, uint32_t* buffer, int w, int h, const char* name) {
+  fprintf(outfile,"SCALARS %s float 1\n", name);
+  fprintf(outfile,"LOOKUP_TABLE default\n");
+  convert2BigEndian(currentfield, buffer, w*h);
+  fwrite(buffer, sizeof(uint32_t), (size_t) w*h, outfile);
+  fprintf(outfile,"\n");
 }
 
-void writeVTK(unsigned* currentfield, int w, int h, int t, char* prefix) {
+void writeVTK(const cell_t* currentfield, uint32_t* buffer, int w, int h, int t, char* prefix) {
   char name[1024] = "\0";
-  sprintf(name, "%s_%d.vtk", prefix, t);
+  snprintf(name, sizeof(name), "%s_%d.vtk", prefix, t);
   FILE* outfile = fopen(name, "w");
-
-  /*Write vtk header */                                                           
-  fprintf(outfile,"# vtk DataFile Version 3.0\n");       
-  fprintf(outfile,"frame %d\n", t);     
-  fprintf(outfile,"BINARY\n");     
-  fprintf(outfile,"DATASET STRUCTURED_POINTS\n");     
-  fprintf(outfile,"DIMENSIONS %d %d %d \n", w, h, 1);        
-  fprintf(outfile,"SPACING 1.0 1.0 1.0\n");//or ASPECT_RATIO                            
-  fprintf(outfile,"ORIGIN 0 0 0\n");                                              
-  fprintf(outfile,"POINT_DATA %d\n", h*w);                                    
-  fprintf(outfile,"SCALARS data float 1\n");                              
-  fprintf(outfile,"LOOKUP_TABLE default\n");         
- 
-  for (int y = 0; y < h; y++) {
-    for (int x = 0; x < w; x++) {
-      float value = currentfield[calcIndex(w, x,y)]; // != 0.0 ? 1.0:0.0;
-      value = convert2BigEndian(value);
-      fwrite(&value, 1, sizeof(float), outfile);
-    }
+  if (outfile == NULL) {
+    fprintf(stderr, "ERROR: Could not open %s\n", name);
+    return;
   }
+
+  char title[64];
+  snprintf(title, sizeof(title), "frame %d", t);
+  writeHeader(outfile, w, h, title);
+  writeScalars(outfile, currentfield, buffer, w, h, "data");
   fclose(outfile);
 }
 
- 
-int evolve(unsigned* currentfield, unsigned* newfield, int w, int h) {
-int changes = 0;
+// Conway's rules on a torus; returns the number of cells that changed
+int evolve(const cell_t* currentfield, cell_t* newfield, int w, int h) {
+  int changes = 0;
+#pragma omp parallel for reduction(+:changes)
   for (int y = 0; y < h; y++) {
+    const cell_t* up   = currentfield + calcIndex(w, 0, (y + h - 1) % h);
+    const cell_t* row  = currentfield + calcIndex(w, 0, y);
+    const cell_t* down = currentfield + calcIndex(w, 0, (y + 1) % h);
     for (int x = 0; x < w; x++) {
-    
-    //TODO add game of life rules     
-
+      int left = x == 0 ? w - 1 : x - 1;
+      int right = x == w - 1 ? 0 : x + 1;
+      int neighbours = up[left] + up[x] + up[right] + row[left] + row[right] + down[left] + down[x] + down[right];
+      cell_t alive = neighbours == 3 || (neighbours == 2 && row[x]);
+      newfield[calcIndex(w, x,y)] = alive;
+      changes += alive != row[x];
     }
   }
-//TODO if changes == 0, the time loop will not run! 
   return changes;
 }
- 
-void filling(unsigned* currentfield, int w, int h) {
+
+void filling(cell_t* currentfield, int w, int h) {
   for (int i = 0; i < h*w; i++) {
     currentfield[i] = (rand() < RAND_MAX / 10) ? 1 : 0; ///< init domain randomly
   }
 }
- 
-void game(int w, int h, int timesteps) {
-  unsigned *currentfield = calloc(w*h, sizeof(unsigned));
-  unsigned *newfield     = calloc(w*h, sizeof(unsigned));
-  
+
+void game(int w, int h, int timesteps, char* stream, bool show) {
+  cell_t *currentfield = calloc((size_t) w*h, sizeof(cell_t));
+  cell_t *newfield     = calloc((size_t) w*h, sizeof(cell_t));
+  uint32_t *buffer     = malloc((size_t) w*h * sizeof(uint32_t));
+
+  // All time steps in one file, or one output_<t>.vtk per step
+  FILE *streamfile = NULL;
+  if (stream != NULL) {
+    streamfile = fopen(stream, "w");
+    if (streamfile == NULL) {
+      fprintf(stderr, "ERROR: Could not open %s\n", stream);
+      exit(1);
+    }
+    writeHeader(streamfile, w, h, "frames");
+  }
+
+  renderer_t renderer;
+  show = show && render_open(&renderer, w, h, RENDER_DEFAULT_FPS, GLYPHS_BRAILLE);
+
   filling(currentfield, w, h);
-  for (int t = 0; t < timesteps; t++) {
-// TODO consol output
-//     show(currentfield, w, h);
-    writeVTK(currentfield, w, h, t, "output");
+  int t;
+  for (t = 0; t < timesteps; t++) {
+    if (show) render_submit(&renderer, currentfield, t);
+    if (streamfile != NULL) {
+      char name[32];
+      snprintf(name, sizeof(name), "step_%05d", t);
+      writeScalars(streamfile, currentfield, buffer, w, h, name);
+    } else {
+      writeVTK(currentfield, buffer, w, h, t, "output");
+    }
     int changes = evolve(currentfield, newfield, w, h);
     if (changes == 0) {
-    	sleep(3);
-    	break;
+      break;
     }
-    
-   // usleep(200000);
 
     //SWAP
-    unsigned *temp = currentfield;
+    cell_t *temp = currentfield;
     currentfield = newfield;
     newfield = temp;
   }
-  
+
+  if (show) render_close(&renderer, currentfield, t);
+  if (streamfile != NULL) fclose(streamfile);
   free(currentfield);
   free(newfield);
+  free(buffer);
 }
- 
+
 int main(int c, char **v) {
-     
+
   int w = 0, h = 0, timesteps = 10;
-  if (c > 1) w = atoi(v[1]); ///< read width
-  if (c > 2) h = atoi(v[2]); ///< read height
-  if (c > 3) timesteps = atoi(v[3]);
+  char* stream = NULL;
+  bool show = false;
+  int positional = 0;
+  for (int i = 1; i < c; i++) {
+    if (strcmp(v[i], "--stream") == 0 && i + 1 < c) {
+      stream = v[++i]; ///< single appendable output file
+    } else if (strcmp(v[i], "--show") == 0) {
+      show = true;
+    } else if (positional == 0) {
+      w = atoi(v[i]); positional++; ///< read width
+    } else if (positional == 1) {
+      h = atoi(v[i]); positional++; ///< read height
+    } else if (positional == 2) {
+      timesteps = atoi(v[i]); positional++;
+    }
+  }
   if (w <= 0) w = 30; ///< default width
   if (h <= 0) h = 30; ///< default height
-  game(w, h, timesteps);
+  game(w, h, timesteps, stream, show);
 }
@@ -1,3 +1,5 @@
+#define _GNU_SOURCE
+
 #ifdef _WIN32
 #include <mem.h>
 #endif
@@ -12,30 +14,71 @@
 #include <time.h>
 #include <stdbool.h>
 
+#define TIMING_NOW() omp_get_wtime()
+#include "timing.h"
+#include "perf_counters.h"
+#include "rules.h"
+#include "analytics.h"
+#include "render.h"
+#include "ltl.h"
+
 #define calcIndex(width, x, y)  ((y)*(width) + (x))
 
 #define TIME_STEPS 100
 
 void game(char *filename, int width, int height, int blocks_x, int blocks_y);
 
+void game_ltl(char *filename, int width, int height, int num_threads);
+
 char *init_field(char *current_field, char *filename, int width, int height);
 
-void
-evolve(const char *current_field, char *new_field, int block_width, int block_height, int total_width, int total_height, int offset_x, int offset_y);
+void init_field_seeded(char *current_field, unsigned seed, int width, int height);
 
-int count_living_neighbours(const char *field, int x, int y, int width, int height);
+// One board of a batch run: a pattern file, or a random board from seed
+typedef struct {
+    rule_t rule;
+    unsigned seed;
+    char *pattern;
+} board_t;
+
+int read_batch(char *filename, int count, board_t **boards);
+
+void batch(board_t *boards, int count, int width, int height, char *summary_filename);
+
+// stats may be NULL; otherwise the kernel adds the analytics of its block to it. Returns true if a cell changed
+typedef bool (*evolve_fn)(const char *current_field, char *new_field, int block_width, int block_height, int total_width,
+                          int total_height, int offset_x, int offset_y, rule_t rule, step_stats_t *stats);
+
+bool
+evolve(const char *current_field, char *new_field, int block_width, int block_height, int total_width, int total_height, int offset_x, int offset_y, rule_t rule, step_stats_t *stats);
 
-void print_field(const char *field, int width, int height);
+evolve_fn select_evolve(rule_t rule);
 
-void write(char *filename, const char *field, int block_width, int block_height, int total_width, int total_height,
+int count_living_neighbours(const char *field, int x, int y, int width, int height);
+
+void writeVTK(char *filename, const char *field, int block_width, int block_height, int total_width, int total_height,
            int offset_x, int offset_y);
 
 bool print = true;
+int fps = RENDER_DEFAULT_FPS;
+glyphs_t glyphs = GLYPHS_BRAILLE;
+char *timing_filename = NULL;
+bool perf = false;
+rule_t rule = RULE_CONWAY;
+bool ltl = false;
+ltl_rule_t ltl_rule;
+int batch_count = 0;
+char *batch_filename = NULL;
+char *summary_filename = "batch_summary.csv";
+char *analytics_filename = NULL;
+int frame_every = 0;
+double frame_trigger = 0.0;
 
 int main(int argc, char *argv[]) {
 
     char *filename = "";
     int width = 10, height = 10, blocks_x = 3, blocks_y = 3;
+    bool rule_given = false;
 
     for (int i = 1; i < argc; ++i) {
         if (strcmp(argv[i], "-i") == 0) {
@@ -65,7 +108,100 @@ int main(int argc, char *argv[]) {
             blocks_y = atol(argv[i]);
         } else if (strcmp(argv[i], "--no-print") == 0 || strcmp(argv[i], "-np") == 0) {
             print = false;
+        } else if (strcmp(argv[i], "--fps") == 0 && i + 1 < argc) {
+            fps = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--glyphs") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "braille") == 0) {
+                glyphs = GLYPHS_BRAILLE;
+            } else if (strcmp(argv[i], "half") == 0) {
+                glyphs = GLYPHS_HALF;
+            } else {
+                fprintf(stderr, "ERROR: Unknown glyphs %s, expected braille or half\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--timing") == 0) {
+            i++;
+            if (i >= argc) {
+                fprintf(stderr, "ERROR: Missing timing file parameter");
+                return 1;
+            }
+            timing_filename = argv[i];
+        } else if (strcmp(argv[i], "--perf") == 0) {
+            perf = true;
+        } else if (strcmp(argv[i], "-r") == 0 || strcmp(argv[i], "--rule") == 0) {
+            i++;
+            if (i >= argc || rule_parse(argv[i], &rule) != 0) {
+                fprintf(stderr, "ERROR: Missing or invalid rule, expected B.../S...\n");
+                return 1;
+            }
+            rule_given = true;
+        } else if (strcmp(argv[i], "--ltl") == 0) {
+            i++;
+            if (i >= argc || ltl_parse(argv[i], &ltl_rule) != 0) {
+                fprintf(stderr, "ERROR: Missing or invalid Larger than Life rule, expected e.g. R5,C2,M1,S34..58,B34..45,NM\n");
+                return 1;
+            }
+            ltl = true;
+        } else if (strcmp(argv[i], "--batch") == 0) {
+            i++;
+            if (i >= argc || (batch_count = atoi(argv[i])) <= 0) {
+                fprintf(stderr, "ERROR: Missing or invalid board count\n");
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--batch-file") == 0) {
+            i++;
+            if (i >= argc) {
+                fprintf(stderr, "ERROR: Missing batch file parameter\n");
+                return 1;
+            }
+            batch_filename = argv[i];
+        } else if (strcmp(argv[i], "--analytics") == 0) {
+            i++;
+            if (i >= argc) {
+                fprintf(stderr, "ERROR: Missing analytics file parameter\n");
+                return 1;
+            }
+            analytics_filename = argv[i];
+        } else if (strcmp(argv[i], "--frame-every") == 0 && i + 1 < argc) {
+            frame_every = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--frame-trigger") == 0 && i + 1 < argc) {
+            frame_trigger = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--summary") == 0) {
+            i++;
+            if (i >= argc) {
+                fprintf(stderr, "ERROR: Missing summary file parameter\n");
+                return 1;
+            }
+            summary_filename = argv[i];
+        }
+    }
+
+    // The Larger than Life path has its own rule and no analytics, counters or batch mode
+    if (ltl && (rule_given || analytics_filename != NULL || frame_every > 0 || frame_trigger > 0.0 || perf ||
+                batch_count > 0 || batch_filename != NULL)) {
+        fprintf(stderr, "ERROR: --ltl cannot be combined with -r, --analytics, --frame-every, --frame-trigger, --perf or --batch\n");
+        return 1;
+    }
+
+    if (batch_count > 0 || batch_filename != NULL) {
+        board_t *boards = NULL;
+        int count = read_batch(batch_filename, batch_count, &boards);
+        if (count <= 0) {
+            fprintf(stderr, "ERROR: No boards in batch\n");
+            return 1;
+        }
+        batch(boards, count, width, height, summary_filename);
+        for (int b = 0; b < count; ++b) {
+            free(boards[b].pattern);
         }
+        free(boards);
+        return 0;
+    }
+
+    if (ltl) {
+        game_ltl(filename, width * blocks_x, height * blocks_y, blocks_x * blocks_y);
+        return 0;
     }
 
     game(filename, width, height, blocks_x, blocks_y);
@@ -81,28 +217,63 @@ void game(char *filename, int width, int height, int blocks_x, int blocks_y) {
     char *new_field = calloc((size_t) (total_height * total_width), sizeof(char));
     init_field(current_field, filename, total_width, total_height);
 
-    double cpu_time_used_total = 0;
-    clock_t start = clock(), end;
+    int num_threads = blocks_x * blocks_y;
+    evolve_fn evolve_kernel = select_evolve(rule);
+    char rulestring[32];
+    rule_format(rule, rulestring, sizeof(rulestring));
+    printf("Rule: %s (%s kernel)\n", rulestring, evolve_kernel == evolve ? "generic" : "specialized");
+    phase_timer_t *timers = timing_alloc(num_threads);
+    double step_start = 0, step_time_total = 0;
+    perf_counters_t perf_total;
+    memset(&perf_total, 0, sizeof(perf_total));
+    for (int e = 0; e < PERF_EVENT_COUNT; ++e) {
+        perf_total.available[e] = 1;
+    }
+
+    // Per thread stats of the current step, merged by one thread after the step
+    bool analyse = analytics_filename != NULL;
+    analytics_t analytics;
+    step_stats_t *thread_stats = analyse ? calloc((size_t) num_threads, sizeof(step_stats_t)) : NULL;
+    bool write_frame = false;
+    if (analyse && !analytics_open(&analytics, analytics_filename, frame_every, frame_trigger)) {
+        analyse = false;
+    }
+
+    // Live view on its own thread, the time steps only hand it a snapshot when a frame is due
+    renderer_t renderer;
+    bool render = print && render_open(&renderer, total_width, total_height, fps, glyphs);
+    if (render) {
+        render_submit(&renderer, current_field, 0);
+    }
 
-#pragma omp parallel num_threads(blocks_x * blocks_y)
+#pragma omp parallel num_threads(num_threads)
     {
         int thread_num = omp_get_thread_num();
-        int offset_y = (thread_num / blocks_y) * height;
+        int offset_y = (thread_num / blocks_x) * height;
         int offset_x = (thread_num % blocks_x) * width;
+        phase_timer_t *timer = &timers[thread_num];
+        perf_counters_t counters;
+        if (perf) {
+            perf_counters_open(&counters);
+        }
 
         for (int t = 0; t < TIME_STEPS; ++t) {
 
-            if(print) {
-#pragma omp single
-                print_field(current_field, total_width, total_height);
-            }
+#pragma omp master
+            step_start = TIMING_NOW();
             //printf("Thread %d at subfield position %d, offset_x: %d, offset_y: %d\n", thread_num, calcIndex(total_width, offset_x, offset_y), offset_x, offset_y);
 
-            evolve(current_field, new_field, width, height, total_width, total_height, offset_x, offset_y);
+            step_stats_t *stats = NULL;
+            if (analyse) {
+                stats = &thread_stats[thread_num];
+                stats_reset(stats, 0);
+            }
 
-            char thread_filename[2048];
-            snprintf(thread_filename, sizeof(thread_filename), "t%d-%05d%s", thread_num, t, ".vti");
-            //write(thread_filename, current_field, width, height, total_width, total_height, offset_x, offset_y);
+            timer_start(timer);
+            if (perf) perf_counters_start(&counters);
+            evolve_kernel(current_field, new_field, width, height, total_width, total_height, offset_x, offset_y, rule, stats);
+            if (perf) perf_counters_stop(&counters);
+            timer_stop(timer, PHASE_EVOLVE);
 
 #pragma omp barrier
 #pragma omp single
@@ -111,24 +282,142 @@ void game(char *filename, int width, int height, int blocks_x, int blocks_y) {
                 current_field = new_field;
                 new_field = tmp;
 
-                end = clock();
-                double cpu_time_used = ((end - start) * 1000.0) / CLOCKS_PER_SEC;
-                cpu_time_used_total += cpu_time_used;
+                if (analyse) {
+                    timer_start(timer);
+                    for (int i = 1; i < num_threads; ++i) {
+                        stats_merge(&thread_stats[0], &thread_stats[i]);
+                    }
+                    write_frame = analytics_record(&analytics, t, &thread_stats[0]);
+                    timer_stop(timer, PHASE_ANALYTICS);
+                }
+
+                double step_time = TIMING_NOW() - step_start;
+                step_time_total += step_time;
 
-                printf("Time step: %d CPU time: %.3f ms\n", t, cpu_time_used);
-                if(print) {
-                    getchar();
+                if (render) {
+                    timer_start(timer);
+                    render_submit(&renderer, current_field, t + 1);
+                    timer_stop(timer, PHASE_IO);
+                } else {
+                    printf("Time step: %d Wall time: %.3f ms\n", t, step_time * 1000.0);
                 }
-                start = clock();
             }
+
+            // Full frames only when the analytics ask for one
+            if (write_frame) {
+                timer_start(timer);
+                char thread_filename[2048];
+                snprintf(thread_filename, sizeof(thread_filename), "t%d-%05d%s", thread_num, t, ".vti");
+                writeVTK(thread_filename, current_field, width, height, total_width, total_height, offset_x, offset_y);
+                timer_stop(timer, PHASE_IO);
+            }
+        }
+
+        if (perf) {
+            perf_counters_close(&counters);
+#pragma omp critical
+            perf_counters_accumulate(&perf_total, &counters);
         }
     }
 
+    if (render) {
+        render_close(&renderer, current_field, TIME_STEPS);
+    }
+
+    double *totals = malloc(num_threads * PHASE_COUNT * sizeof(double));
+    for (int i = 0; i < num_threads; ++i) {
+        memcpy(&totals[i * PHASE_COUNT], timers[i].total, sizeof(timers[i].total));
+    }
+
     printf("\n----- -----\n");
-    printf("Average CPU time: %.3f ms\n", cpu_time_used_total / TIME_STEPS);
+    printf("Average wall time: %.3f ms\n", step_time_total * 1000.0 / TIME_STEPS);
+    timing_print(stdout, "thread", totals, num_threads, TIME_STEPS);
+    if (timing_filename != NULL) {
+        timing_write(timing_filename, "thread", totals, num_threads, TIME_STEPS);
+    }
+    if (perf) {
+        perf_counters_print(stdout, &perf_total, (double) total_width * total_height * TIME_STEPS);
+    }
+
+    if (analyse) {
+        analytics_close(&analytics);
+    }
+    free(thread_stats);
+    free(totals);
+    free(timers);
+    free(current_field);
+    free(new_field);
 }
 
-void write(char *filename, const char *field, int block_width, int block_height, int total_width, int total_height,
+// Larger than Life on the whole board; ltl_evolve() splits the rows between the threads itself
+void game_ltl(char *filename, int width, int height, int num_threads) {
+    int r = ltl_rule.radius;
+    if (width < 2 * r + 1 || height < 2 * r + 1) {
+        fprintf(stderr, "ERROR: Board of %dx%d is too small for radius %d\n", width, height, r);
+        return;
+    }
+
+    // r wrapped ghost rows above and below the board
+    size_t padded_length = (size_t) (height + 2 * r) * width;
+    char *current_field = calloc(padded_length, sizeof(char));
+    char *new_field = calloc(padded_length, sizeof(char));
+    init_field(current_field + r * width, filename, width, height);
+
+    omp_set_num_threads(num_threads);
+    printf("Rule: R%d,C2,M%d,S%d..%d,B%d..%d,NM (Larger than Life, %d threads)\n", r, ltl_rule.center,
+           ltl_rule.survive_min, ltl_rule.survive_max, ltl_rule.birth_min, ltl_rule.birth_max, num_threads);
+    phase_timer_t *timer = timing_alloc(1);
+    renderer_t renderer;
+    bool render = print && render_open(&renderer, width, height, fps, glyphs);
+    double step_time_total = 0;
+
+    for (int t = 0; t < TIME_STEPS; ++t) {
+        double step_start = TIMING_NOW();
+
+        timer_start(timer);
+        memcpy(current_field, current_field + (size_t) height * width, (size_t) r * width);
+        memcpy(current_field + (size_t) (height + r) * width, current_field + (size_t) r * width, (size_t) r * width);
+        timer_stop(timer, PHASE_HALO);
+
+        timer_start(timer);
+        ltl_evolve(&ltl_rule, current_field, new_field + (size_t) r * width, width, height);
+        timer_stop(timer, PHASE_EVOLVE);
+
+        char *tmp = current_field;
+        current_field = new_field;
+        new_field = tmp;
+
+        double step_time = TIMING_NOW() - step_start;
+        step_time_total += step_time;
+        if (render) {
+            render_submit(&renderer, current_field + (size_t) r * width, t + 1);
+        } else {
+            printf("Time step: %d Wall time: %.3f ms\n", t, step_time * 1000.0);
+        }
+    }
+
+    if (render) {
+        render_close(&renderer, current_field + (size_t) r * width, TIME_STEPS);
+    }
+
+    long population = 0;
+    for (size_t i = (size_t) r * width; i < (size_t) (r + height) * width; ++i) {
+        population += current_field[i];
+    }
+    printf("\n----- -----\n");
+    printf("Average wall time: %.3f ms\n", step_time_total * 1000.0 / TIME_STEPS);
+    printf("Population: %ld\n", population);
+    timing_print(stdout, "thread", timer->total, 1, TIME_STEPS);
+    if (timing_filename != NULL) {
+        timing_write(timing_filename, "thread", timer->total, 1, TIME_STEPS);
+    }
+
+    free(timer);
+    free(current_field);
+    free(new_field);
+}
+
+void writeVTK(char *filename, const char *field, int block_width, int block_height, int total_width, int total_height,
            int offset_x, int offset_y) {
     int x, y;
     float deltax = 1.0;
@@ -162,17 +451,38 @@ void write(char *filename, const char *field, int block_width, int block_height,
     fclose(fp);
 }
 
-void
-evolve(const char *current_field, char *new_field, int block_width, int block_height, int total_width, int total_height, int offset_x, int offset_y) {
+// Kernel body for RULE_DEFINE_KERNELS
+static inline __attribute__((always_inline)) bool
+evolve_rule(unsigned birth, unsigned survive, const char *current_field, char *new_field, int block_width, int block_height, int total_width, int total_height, int offset_x, int offset_y, step_stats_t *stats) {
+    // Counted in a local copy: new_field stores may alias *stats, and neighbouring threads' stats share lines
+    step_stats_t local;
+    if (stats != NULL) {
+        stats_reset(&local, stats->origin_y);
+    }
+    bool change = false;
     for (int y = offset_y; y < offset_y + block_height; ++y) {
         for (int x = offset_x; x < offset_x + block_width; ++x) {
             int index = calcIndex(total_width, x, y);
             int neighbours = count_living_neighbours(current_field, x, y, total_width, total_height);
-            new_field[index] = (neighbours == 3 || (neighbours == 2 && current_field[index]));
+            new_field[index] = RULE_NEXT(birth, survive, current_field[index], neighbours);
+            change |= new_field[index] != current_field[index];
+            if (stats != NULL) {
+                stats_add_cell(&local, x, y, total_width, current_field[index], new_field[index], neighbours);
+            }
         }
     }
+    if (stats != NULL) {
+        stats_merge(stats, &local);
+    }
+    return change;
 }
 
+RULE_DEFINE_KERNELS(evolve_fn, select_evolve, evolve, evolve_rule,
+                    (const char *current_field, char *new_field, int block_width, int block_height, int total_width,
+                     int total_height, int offset_x, int offset_y, rule_t rule, step_stats_t *stats),
+                    (current_field, new_field, block_width, block_height, total_width, total_height, offset_x,
+                     offset_y, stats))
+
 int count_living_neighbours(const char *field, int x, int y, int width, int height) {
     int number = 0;
     for (int iy = y - 1; iy <= y + 1; iy++) {
@@ -191,16 +501,18 @@ char *init_field(char *current_field, char *filename, int width, int height) {
         fp = fopen(filename, "r");
 
         if (fp != NULL) {
+            char *line = NULL;
+            size_t len = 0;
             for (int y = 0; y < height; ++y) {
-                char *line = NULL;
-                size_t len = 0;
-                size_t read = getline(&line, &len, fp);
+                ssize_t read = getline(&line, &len, fp);
 
                 for (int x = 0; x < width; ++x) {
                     current_field[calcIndex(width, x, y)] = (char) (x < read && (line[x] == 'X' || line[x] == 'x') ? 1
                                                                                                                    : 0); //TODO: Is cast necessary
                 }
             }
+            free(line);
+            fclose(fp);
         } else {
             fprintf(stderr, "WARNING: Could not open file");
         }
@@ -210,14 +522,149 @@ char *init_field(char *current_field, char *filename, int width, int height) {
         }
     }
 
-    return calloc(10, sizeof(char));
+    return current_field;
 }
 
-void print_field(const char *field, int width, int height) {
-    for (int y = 0; y < height; ++y) {
-        for (int x = 0; x < width; ++x) {
-            printf("%c", field[calcIndex(width, x, y)] ? 'X' : ' ');
+void init_field_seeded(char *current_field, unsigned seed, int width, int height) {
+    for (int i = 0; i < width * height; i++) {
+        current_field[i] = (char) ((rand_r(&seed) < RAND_MAX / 10) ? 1 : 0);
+    }
+}
+
+// Reads "[rule] [seed|pattern file]" lines, or generates count boards with seeds 1..count and the global rule
+int read_batch(char *filename, int count, board_t **boards) {
+    if (filename == NULL) {
+        *boards = calloc((size_t) count, sizeof(board_t));
+        for (int b = 0; b < count; ++b) {
+            (*boards)[b].rule = rule;
+            (*boards)[b].seed = (unsigned) b + 1;
         }
-        printf("|\n");
+        return count;
+    }
+
+    FILE *fp = fopen(filename, "r");
+    if (fp == NULL) {
+        fprintf(stderr, "ERROR: Could not open batch file %s\n", filename);
+        return -1;
     }
+    int capacity = 64;
+    count = 0;
+    *boards = malloc(capacity * sizeof(board_t));
+    char *line = NULL;
+    size_t len = 0;
+    while (getline(&line, &len, fp) > 0) {
+        char tokens[2][1024];
+        int token_count = sscanf(line, "%1023s %1023s", tokens[0], tokens[1]);
+        if (token_count <= 0 || tokens[0][0] == '#') continue;
+
+        if (count == capacity) {
+            capacity *= 2;
+            *boards = realloc(*boards, capacity * sizeof(board_t));
+        }
+        board_t *board = &(*boards)[count];
+        board->rule = rule;
+        board->seed = (unsigned) count + 1;
+        board->pattern = NULL;
+        for (int t = 0; t < token_count; ++t) {
+            char *end;
+            unsigned long seed = strtoul(tokens[t], &end, 10);
+            if (rule_parse(tokens[t], &board->rule) == 0) {
+                continue;
+            } else if (*end == '\0') {
+                board->seed = (unsigned) seed;
+            } else {
+                free(board->pattern);
+                board->pattern = strdup(tokens[t]);
+            }
+        }
+        count++;
+    }
+    free(line);
+    fclose(fp);
+    return count;
+}
+
+static long population(const char *field, int length) {
+    long living = 0;
+    for (int i = 0; i < length; ++i) {
+        living += field[i];
+    }
+    return living;
+}
+
+// Evolves every board serially inside one task, boards are spread over the threads
+void batch(board_t *boards, int count, int width, int height, char *summary_filename) {
+    int area = width * height;
+    long *initial = malloc(count * sizeof(long));
+    long *final = malloc(count * sizeof(long));
+    int *steps = malloc(count * sizeof(int));
+    int *period = malloc(count * sizeof(int));
+
+    double start = omp_get_wtime();
+#pragma omp parallel
+    {
+        // current, next and the generation before current, for period 1 and 2 detection
+        char *fields = malloc(3 * (size_t) area);
+
+#pragma omp for schedule(dynamic)
+        for (int b = 0; b < count; ++b) {
+            char *current = fields, *next = fields + area, *previous = fields + 2 * area;
+            if (boards[b].pattern != NULL) {
+                memset(current, 0, (size_t) area);
+                init_field(current, boards[b].pattern, width, height);
+            } else {
+                init_field_seeded(current, boards[b].seed, width, height);
+            }
+            evolve_fn kernel = select_evolve(boards[b].rule);
+            initial[b] = population(current, area);
+            period[b] = 0;
+
+            int t = 0;
+            while (t < TIME_STEPS && period[b] == 0) {
+                kernel(current, next, width, height, width, height, 0, 0, boards[b].rule, NULL);
+                if (memcmp(next, current, (size_t) area) == 0) {
+                    period[b] = 1;
+                } else if (t > 0 && memcmp(next, previous, (size_t) area) == 0) {
+                    period[b] = 2;
+                }
+                char *tmp = previous;
+                previous = current;
+                current = next;
+                next = tmp;
+                t++;
+            }
+            steps[b] = t;
+            final[b] = population(current, area);
+        }
+
+        free(fields);
+    }
+    double elapsed = omp_get_wtime() - start;
+
+    FILE *fp = fopen(summary_filename, "w");
+    if (fp != NULL) {
+        fprintf(fp, "board,rule,seed,pattern,width,height,steps,initial_population,final_population,period\n");
+        for (int b = 0; b < count; ++b) {
+            char rulestring[32];
+            rule_format(boards[b].rule, rulestring, sizeof(rulestring));
+            fprintf(fp, "%d,%s,%u,%s,%d,%d,%d,%ld,%ld,%d\n", b, rulestring, boards[b].seed,
+                    boards[b].pattern ? boards[b].pattern : "", width, height, steps[b], initial[b], final[b], period[b]);
+        }
+        fclose(fp);
+    } else {
+        fprintf(stderr, "WARNING: Could not open summary file %s\n", summary_filename);
+    }
+
+    // Boards that settle early stop before TIME_STEPS, only the steps actually computed count
+    long total_steps = 0;
+    for (int b = 0; b < count; ++b) {
+        total_steps += steps[b];
+    }
+    printf("Batch: %d boards of %dx%d on %d threads in %.3f s: %.1f boards/s, %.1f Mcells/s\n", count, width, height,
+           omp_get_max_threads(), elapsed, count / elapsed, (double) area * total_steps / elapsed / 1e6);
+
+    free(initial);
+    free(final);
+    free(steps);
+    free(period);
 }
@@ -22,6 +22,7 @@ int main(int argc, char **argv) {
 	else
 		omp_set_num_threads(6);
 
+	double start = omp_get_wtime();
 	#pragma omp parallel reduction(+:globalCount) 
 	{
 		#pragma omp for
@@ -34,6 +35,7 @@ int main(int argc, char **argv) {
   double pi = 4.0 * (double)globalCount / (double)(globalSamples);
  
   printf("pi is %.9lf\n", pi);
+  printf("Time: %.3f ms\n", (omp_get_wtime() - start) * 1000.0);
   
   return 0;
 }